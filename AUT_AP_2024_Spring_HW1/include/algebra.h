@@ -1,14 +1,19 @@
 #ifndef AUT_AP_2024_Spring_HW1
 #define AUT_AP_2024_Spring_HW1
 
-#include <format>
+#include <cmath>
+#include <complex>
 #include <iostream>
 #include <limits>
 #include <optional>
 #include <random>
 #include <stdexcept>
+#include <type_traits>
 #include <vector>
 
+#include "format.h"
+#include "instrument.h"
+
 namespace algebra {
 
     // 矩阵数据结构
@@ -21,6 +26,29 @@ namespace algebra {
                             Identity,
                             Random };
 
+    namespace detail {
+
+        template<typename T>
+        struct is_complex : std::false_type {};
+
+        template<typename T>
+        struct is_complex<std::complex<T>> : std::true_type {};
+
+        // T 是否为 std::complex
+        template<typename T>
+        constexpr bool is_complex_v = is_complex<T>::value;
+
+        // 随机矩阵的上下界是否有效: 复数要求实部与虚部分别满足 lower < upper
+        template<typename T>
+        bool bounds_ordered(const T &lower, const T &upper) {
+            if constexpr (is_complex_v<T>)
+                return lower.real() < upper.real() && lower.imag() < upper.imag();
+            else
+                return lower < upper;
+        }
+
+    }// namespace detail
+
     // 矩阵初始化函数模板
     template<typename T>
     MATRIX<T> create_matrix(std::size_t rows, std::size_t columns,
@@ -48,31 +76,40 @@ namespace algebra {
                     if (i == j)
                         mtx[i][j] = 1;
         } else {
-            if (lowerBound >= upperBound)
+            if (!lowerBound || !upperBound || !detail::bounds_ordered(*lowerBound, *upperBound))
                 throw std::invalid_argument("Invalid bounds for random matrix.");
 
             mtx.resize(rows, std::vector<T>(columns, 0));
 
             std::random_device rd{};// 用于生成随机种子
             std::mt19937 rand(rd());// 使用 Mersenne Twister 引擎
-            std::uniform_real_distribution<> dis(lowerBound.value(), upperBound.value() + std::numeric_limits<double>::epsilon());
 
-            for (std::size_t i = 0; i < rows; ++i)
-                mtx[i][i] = dis(rand);
+            if constexpr (detail::is_complex_v<T>) {
+                // 实部与虚部分别在各自的区间内均匀分布
+                using R = typename T::value_type;
+                std::uniform_real_distribution<R> re(lowerBound->real(), upperBound->real());
+                std::uniform_real_distribution<R> im(lowerBound->imag(), upperBound->imag());
+                for (std::size_t i = 0; i < rows; ++i)
+                    for (std::size_t j = 0; j < columns; ++j)
+                        mtx[i][j] = T(re(rand), im(rand));
+            } else {
+                std::uniform_real_distribution<> dis(lowerBound.value(), upperBound.value() + std::numeric_limits<double>::epsilon());
+                for (std::size_t i = 0; i < rows; ++i)
+                    for (std::size_t j = 0; j < columns; ++j)
+                        mtx[i][j] = static_cast<T>(dis(rand));
+            }
         }
 
-        return std::move(mtx);
+        return mtx;
     }
 
+    // 输出矩阵, 默认每个元素居中占 7 个字符宽度; 经缓冲后整块写出, 大矩阵可通过 edge_items 只输出首尾
     template<typename T>
-    void display(const MATRIX<T> &matrix) {
-        for (const auto &row: matrix) {
-            std::string row_str;
-            for (const auto &elem: row) {
-                row_str += std::format("|{:^7}", elem);// 每个元素占 4 个字符宽度
-            }
-            std::cout << row_str << '|' << std::endl;
-        }
+    void display(const MATRIX<T> &matrix, FormatOptions options = {}, std::ostream &out = std::cout) {
+        std::size_t cols = matrix.empty() ? 0 : matrix[0].size();
+        MatrixFormatter(options).write(out, matrix.size(), cols,
+                                       [&](std::size_t i, std::size_t j) -> const T & { return matrix[i][j]; });
+        out.flush();
     }
 
     template<typename T>
@@ -88,6 +125,7 @@ namespace algebra {
 
         if (row_a != row_b || col_a != col_b)
             throw std::invalid_argument("Matrix dimension mismatch.");
+        ALGEBRA_TRACE("sum_sub", row_a, col_a, 1, row_a * col_a, 3.0 * row_a * col_a * sizeof(T));
 
         MATRIX<T> res{matrixA};
 
@@ -101,7 +139,7 @@ namespace algebra {
                     res[i][j] += matrixB[i][j];
         }
 
-        return std::move(res);
+        return res;
     }
 
     template<typename T>
@@ -110,6 +148,7 @@ namespace algebra {
             return {};
 
         int rows = matrix.size(), cols = matrix[0].size();
+        ALGEBRA_TRACE("multiply (scalar)", rows, cols, 1, rows * cols, 2.0 * rows * cols * sizeof(T));
 
         MATRIX<T> res{matrix};
 
@@ -117,7 +156,7 @@ namespace algebra {
             for (int j = 0; j < cols; ++j)
                 res[i][j] *= scalar;
 
-        return std::move(res);
+        return res;
     }
 
     template<typename T>
@@ -131,6 +170,9 @@ namespace algebra {
         if (col_a != row_b)
             throw std::invalid_argument("Matrix dimension mismatch.");
 
+        ALGEBRA_TRACE("multiply", row_a, col_b, col_a, 2.0 * row_a * col_b * col_a,
+                      (1.0 * row_a * col_a + 1.0 * row_b * col_b + 1.0 * row_a * col_b) * sizeof(T));
+
         MATRIX<T> res(row_a, std::vector<T>(col_b, 0));
 
         for (int i = 0; i < row_a; ++i) {
@@ -140,7 +182,7 @@ namespace algebra {
             }
         }
 
-        return std::move(res);
+        return res;
     }
 
     template<typename T>
@@ -154,13 +196,15 @@ namespace algebra {
         if (row_a != row_b || col_a != col_b)
             throw std::invalid_argument("Matrix dimension mismatch.");
 
+        ALGEBRA_TRACE("hadamard_product", row_a, col_a, 1, row_a * col_a, 3.0 * row_a * col_a * sizeof(T));
+
         MATRIX<T> res(row_a, std::vector<T>(col_a, 0));
 
         for (int i = 0; i < row_a; ++i)
             for (int j = 0; j < col_a; ++j)
                 res[i][j] = matrixA[i][j] * matrixB[i][j];
 
-        return std::move(res);
+        return res;
     }
 
     template<typename T>
@@ -170,10 +214,11 @@ namespace algebra {
 
         int rows = matrix.size();
         int cols = matrix[0].size();
+        ALGEBRA_TRACE("transpose", rows, cols, 1, 0, 2.0 * rows * cols * sizeof(T));
 
         MATRIX<T> zeroMtx(rows, std::vector<T>(cols, 0));
         if (matrix == zeroMtx)
-            return std::move(zeroMtx);
+            return zeroMtx;
 
         MATRIX<T> res(cols, std::vector<T>(rows, 0));
 
@@ -181,7 +226,7 @@ namespace algebra {
             for (int j = 0; j < cols; ++j)
                 res[j][i] = matrix[i][j];
 
-        return std::move(res);
+        return res;
     }
 
     template<typename T>
@@ -220,7 +265,7 @@ namespace algebra {
             ++rowIndex;
         }
 
-        return std::move(subMatrix);
+        return subMatrix;
     }
 
     template<typename T>
@@ -234,6 +279,9 @@ namespace algebra {
         if (rows != cols)
             throw std::invalid_argument("Identity matrix must be square.");
 
+        // 余子式展开约需 e * n! 次乘法
+        ALGEBRA_TRACE("determinant", rows, cols, rows, std::exp(1.0) * std::tgamma(rows + 1.0), 1.0 * rows * cols * sizeof(T));
+
         if (rows == 1)
             return matrix[0][0];
 
@@ -287,6 +335,9 @@ namespace algebra {
         if (rows != cols)
             throw std::invalid_argument("Identity matrix must be square.");
 
+        // 伴随矩阵需要 n^2 个 n - 1 阶行列式
+        ALGEBRA_TRACE("inverse", rows, cols, rows, std::exp(1.0) * rows * std::tgamma(rows + 1.0), 2.0 * rows * cols * sizeof(T));
+
         auto det = determinant(matrix);
         if (det == 0.)
             throw std::invalid_argument("Singular matrix.");
@@ -0,0 +1,372 @@
+#ifndef AUT_AP_2024_Spring_HW1_ASYNC
+#define AUT_AP_2024_Spring_HW1_ASYNC
+
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "algebra.h"
+#include "instrument.h"
+#include "kernel.h"
+#include "lu.h"
+#include "matrix.h"
+#include "precision.h"
+#include "thread_pool.h"
+#include "tuning.h"
+
+// 基于 C++20 协程的异步接口: co_await async::multiply(A, B) 把计算交给全局线程池,
+// 等待期间不占用调用线程. 运算按块执行, 在块之间报告进度并检查取消.
+namespace algebra::async {
+
+    // 运算被取消时在 co_await 处抛出
+    class Cancelled : public std::runtime_error {
+    public:
+        Cancelled() : std::runtime_error("Operation cancelled.") {}
+    };
+
+    // 只读的取消标志, 由 CancellationSource 发出; 默认构造的令牌永远不会被取消
+    class CancellationToken {
+    public:
+        CancellationToken() = default;
+
+        bool cancelled() const { return flag && flag->load(std::memory_order_relaxed); }
+
+    private:
+        friend class CancellationSource;
+        explicit CancellationToken(std::shared_ptr<std::atomic<bool>> flag) : flag{std::move(flag)} {}
+
+        std::shared_ptr<std::atomic<bool>> flag;
+    };
+
+    class CancellationSource {
+    public:
+        CancellationSource() : flag{std::make_shared<std::atomic<bool>>(false)} {}
+
+        CancellationToken token() const { return CancellationToken{flag}; }
+
+        // 正在执行的运算在下一个块的边界处停止
+        void cancel() { flag->store(true, std::memory_order_relaxed); }
+        bool cancelled() const { return flag->load(std::memory_order_relaxed); }
+
+    private:
+        std::shared_ptr<std::atomic<bool>> flag;
+    };
+
+    struct Options {
+        CancellationToken cancel{};
+        // 已完成的比例 (0 到 1, 按运算量估计), 在执行运算的线程中调用
+        std::function<void(double)> progress{};
+        // 运算完成后如何恢复等待的协程, 例如把句柄交回事件循环; 默认直接在线程池线程中恢复
+        std::function<void(std::coroutine_handle<>)> resume{};
+    };
+
+    namespace detail {
+
+        // 每个运算最多分成的块数, 块越多进度越细, 取消越及时, 但每块的 GEMM 越小
+        constexpr std::size_t kAsyncSteps = 32;
+
+        inline std::size_t step(std::size_t extent) {
+            return std::max((extent + kAsyncSteps - 1) / kAsyncSteps, tuning().gemm_block_m);
+        }
+
+        // 报告进度并检查取消
+        inline void checkpoint(const Options &options, double fraction) {
+            if (options.progress)
+                options.progress(fraction);
+            if (options.cancel.cancelled())
+                throw Cancelled{};
+        }
+
+        template<typename T, Layout LA, Layout LB>
+        Matrix<T> multiply_blocks(const Matrix<T, LA> &a, const Matrix<T, LB> &b, const Options &options) {
+            ALGEBRA_TRACE("async::multiply", a.rows(), b.cols(), a.cols(), 2.0 * a.rows() * a.cols() * b.cols(),
+                          (1.0 * a.size() + 1.0 * b.size() + 1.0 * a.rows() * b.cols()) * sizeof(T));
+            std::size_t m = a.rows(), rows = step(m);
+            Matrix<T> res(m, b.cols());
+            checkpoint(options, 0);
+            for (std::size_t r0 = 0; r0 < m; r0 += rows) {
+                std::size_t r1 = std::min(r0 + rows, m);
+                algebra::detail::gemm_kernel(T{1}, a.view().block(r0, 0, r1 - r0, a.cols()), b.view(), T{0},
+                                             res.view().block(r0, 0, r1 - r0, res.cols()));
+                checkpoint(options, static_cast<double>(r1) / m);
+            }
+            return res;
+        }
+
+        // 先做 LU 分解 (约占运算量的 1/4, 不可中断), 再按列块求解单位矩阵
+        template<typename T, Layout L>
+        Matrix<T, L> inverse_blocks(const Matrix<T, L> &a, const Options &options) {
+            std::size_t n = a.rows();
+            ALGEBRA_TRACE("async::inverse", n, n, n, 8.0 / 3.0 * n * n * n, 2.0 * n * n * sizeof(T));
+            checkpoint(options, 0);
+            LU<T> lu(a);
+            if (lu.singular())
+                throw std::invalid_argument("Singular matrix.");
+            checkpoint(options, 0.25);
+
+            Matrix<T, L> res(n, n);
+            std::size_t cols = step(n);
+            for (std::size_t c0 = 0; c0 < n; c0 += cols) {
+                std::size_t c1 = std::min(c0 + cols, n);
+                Matrix<T> rhs(n, c1 - c0);
+                for (std::size_t j = c0; j < c1; ++j)
+                    rhs(j, j - c0) = T{1};
+                Matrix<T> x = lu.solve(rhs);
+                algebra::detail::copy_blocked(std::as_const(x).view(), res.view().block(0, c0, n, c1 - c0));
+                checkpoint(options, 0.25 + 0.75 * static_cast<double>(c1) / n);
+            }
+            return res;
+        }
+
+        inline void check_product(std::size_t rows_a, std::size_t cols_a, std::size_t rows_b, std::size_t cols_b) {
+            if (rows_a == 0 || cols_a == 0 || rows_b == 0 || cols_b == 0)
+                throw std::invalid_argument("Matrices must not be empty.");
+            if (cols_a != rows_b)
+                throw std::invalid_argument("Matrix dimension mismatch.");
+        }
+
+    }// namespace detail
+
+    // 可等待的运算: 第一次 co_await 时提交到线程池, 完成后恢复等待者并返回结果或重新抛出异常.
+    // 可以在任意协程类型中等待. 线程池没有工作线程 (并行度为 1) 时在等待者的线程中直接执行.
+    template<typename R>
+    class [[nodiscard]] Operation {
+    public:
+        Operation(std::function<R(const Options &)> work, Options options)
+            : work{std::move(work)}, options{std::move(options)} {}
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> awaiting) {
+            ThreadPool &pool = ThreadPool::instance();
+            if (pool.concurrency() == 1) {
+                execute();
+                return false;
+            }
+            pool.submit([this, awaiting] {
+                execute();
+                // 恢复之后等待者可能立即销毁本对象, 先取出恢复函数
+                std::function<void(std::coroutine_handle<>)> resume = std::move(options.resume);
+                if (resume)
+                    resume(awaiting);
+                else
+                    awaiting.resume();
+            });
+            return true;
+        }
+
+        R await_resume() {
+            if (error)
+                std::rethrow_exception(error);
+            return std::move(*result);
+        }
+
+    private:
+        void execute() {
+            try {
+                result.emplace(work(options));
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }
+
+        std::function<R(const Options &)> work;
+        Options options;
+        std::optional<R> result;
+        std::exception_ptr error;
+    };
+
+    // 输入按值保存 (写时复制, 只增加引用计数), 调用者在等待期间可以继续修改自己的副本
+    template<typename T, Layout LA, Layout LB>
+    Operation<Matrix<T>> multiply(Matrix<T, LA> matrixA, Matrix<T, LB> matrixB, Options options = {}) {
+        detail::check_product(matrixA.rows(), matrixA.cols(), matrixB.rows(), matrixB.cols());
+        return {[a = std::move(matrixA), b = std::move(matrixB)](const Options &opts) {
+                    return detail::multiply_blocks(a, b, opts);
+                },
+                std::move(options)};
+    }
+
+    template<typename T>
+    Operation<MATRIX<T>> multiply(const MATRIX<T> &matrixA, const MATRIX<T> &matrixB, Options options = {}) {
+        detail::check_product(matrixA.size(), matrixA.empty() ? 0 : matrixA[0].size(),
+                              matrixB.size(), matrixB.empty() ? 0 : matrixB[0].size());
+        return {[a = Matrix<T>(matrixA), b = Matrix<T>(matrixB)](const Options &opts) {
+                    return detail::multiply_blocks(a, b, opts).to_nested();
+                },
+                std::move(options)};
+    }
+
+    template<typename T, Layout L>
+    Operation<Matrix<T, L>> inverse(Matrix<T, L> matrix, Options options = {}) {
+        if (matrix.empty())
+            throw std::invalid_argument("Matrices must not be empty.");
+        if (matrix.rows() != matrix.cols())
+            throw std::invalid_argument("Matrix must be square.");
+        return {[a = std::move(matrix)](const Options &opts) {
+                    return detail::inverse_blocks(a, opts);
+                },
+                std::move(options)};
+    }
+
+    // 与 algebra::inverse 相同, 结果为 double; 以 LU 分解代替伴随矩阵
+    template<typename T>
+    Operation<MATRIX<double>> inverse(const MATRIX<T> &matrix, Options options = {}) {
+        if (matrix.empty())
+            throw std::invalid_argument("Matrices must not be empty.");
+        if (matrix.size() != matrix[0].size())
+            throw std::invalid_argument("Identity matrix must be square.");
+        return {[a = algebra::detail::convert<double>(Matrix<T>(matrix))](const Options &opts) {
+                    return detail::inverse_blocks(a, opts).to_nested();
+                },
+                std::move(options)};
+    }
+
+    // 在线程池中执行任意计算 fn(); 只在开始前检查取消
+    template<typename F>
+        requires(!std::is_void_v<std::invoke_result_t<F &>>)
+    Operation<std::invoke_result_t<F &>> run(F fn, Options options = {}) {
+        return {[fn = std::move(fn)](const Options &opts) mutable {
+                    detail::checkpoint(opts, 0);
+                    auto res = fn();
+                    detail::checkpoint(opts, 1);
+                    return res;
+                },
+                std::move(options)};
+    }
+
+    namespace detail {
+
+        struct TaskPromiseBase {
+            struct FinalAwaiter {
+                bool await_ready() const noexcept { return false; }
+
+                // 对称转移到等待者, 不增加调用栈深度
+                template<typename P>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<P> self) noexcept {
+                    return self.promise().continuation;
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            FinalAwaiter final_suspend() noexcept { return {}; }
+            void unhandled_exception() { error = std::current_exception(); }
+
+            std::coroutine_handle<> continuation = std::noop_coroutine();
+            std::exception_ptr error;
+        };
+
+        template<typename T>
+        struct TaskPromise : TaskPromiseBase {
+            void return_value(T value) { result.emplace(std::move(value)); }
+            std::optional<T> result;
+        };
+
+        template<>
+        struct TaskPromise<void> : TaskPromiseBase {
+            void return_void() {}
+        };
+
+    }// namespace detail
+
+    // 惰性启动的协程: 被 co_await (或交给 sync_wait) 时才开始执行
+    template<typename T = void>
+    class [[nodiscard]] Task {
+    public:
+        struct promise_type : detail::TaskPromise<T> {
+            Task get_return_object() { return Task{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        };
+
+        Task(Task &&other) noexcept : handle{std::exchange(other.handle, {})} {}
+        Task &operator=(Task &&) = delete;
+
+        ~Task() {
+            if (handle)
+                handle.destroy();
+        }
+
+        bool await_ready() const noexcept { return false; }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+            handle.promise().continuation = awaiting;
+            return handle;
+        }
+
+        T await_resume() {
+            auto &promise = handle.promise();
+            if (promise.error)
+                std::rethrow_exception(promise.error);
+            if constexpr (!std::is_void_v<T>)
+                return std::move(*promise.result);
+        }
+
+    private:
+        explicit Task(std::coroutine_handle<promise_type> handle) : handle{handle} {}
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    namespace detail {
+
+        // 立即开始, 结束时自行销毁的协程
+        struct Detached {
+            struct promise_type {
+                Detached get_return_object() noexcept { return {}; }
+                std::suspend_never initial_suspend() noexcept { return {}; }
+                std::suspend_never final_suspend() noexcept { return {}; }
+                void return_void() noexcept {}
+                void unhandled_exception() noexcept { std::terminate(); }
+            };
+        };
+
+        template<typename T>
+        using Stored = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+        template<typename T>
+        Detached drive(Task<T> &task, std::optional<Stored<T>> &result, std::exception_ptr &error,
+                       std::atomic<bool> &done) {
+            try {
+                if constexpr (std::is_void_v<T>) {
+                    co_await task;
+                    result.emplace();
+                } else {
+                    result.emplace(co_await task);
+                }
+            } catch (...) {
+                error = std::current_exception();
+            }
+            // done 置位后 sync_wait 可能立即返回, 之后只能访问本协程帧中的数据
+            ThreadPool &pool = ThreadPool::instance();
+            done = true;
+            pool.notify();
+        }
+
+    }// namespace detail
+
+    // 阻塞当前线程直到 task 完成, 等待期间执行线程池中的任务; 用于测试和同步代码的边界
+    template<typename T>
+    T sync_wait(Task<T> task) {
+        std::optional<detail::Stored<T>> result;
+        std::exception_ptr error;
+        std::atomic<bool> done{false};
+        detail::drive(task, result, error, done);
+        ThreadPool::instance().help_until([&] { return done.load(); });
+        if (error)
+            std::rethrow_exception(error);
+        if constexpr (!std::is_void_v<T>)
+            return std::move(*result);
+    }
+
+}// namespace algebra::async
+
+#endif// AUT_AP_2024_Spring_HW1_ASYNC
@@ -0,0 +1,336 @@
+#ifndef AUT_AP_2024_Spring_HW1_BLAS
+#define AUT_AP_2024_Spring_HW1_BLAS
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "complex.h"
+#include "instrument.h"
+#include "kernel.h"
+#include "matrix.h"
+#include "reduction.h"
+#include "thread_pool.h"
+
+namespace algebra {
+
+    // 操作数变换: 不变, 转置, 共轭转置 (实数时与转置相同)
+    enum class Op { NoTrans,
+                    Trans,
+                    ConjTrans };
+
+    namespace detail {
+
+        // 每个并行块处理的矩阵元素数
+        constexpr std::size_t kLevel2Grain = std::size_t{1} << 15;
+
+        // axpy 形式下每个并行块负责的输出长度, 使输出块留在 L1 缓存中
+        constexpr std::size_t kAxpyBlock = 1024;
+
+        // y = alpha * op(A) * x + beta * y
+        template<typename T, Layout L>
+        void gemv_kernel(Op op, T alpha, MatrixView<const T, L> A, const T *x, T beta, T *y) {
+            std::size_t lines = L == Layout::RowMajor ? A.rows() : A.cols();
+            std::size_t len = L == Layout::RowMajor ? A.cols() : A.rows();
+            auto &pool = ThreadPool::instance();
+
+            if ((op == Op::NoTrans) == (L == Layout::RowMajor)) {
+                // op(A) 的每一行都是 A 的一条连续线: 每个输出是一次内积
+                std::size_t grain = std::max<std::size_t>(1, kLevel2Grain / std::max<std::size_t>(len, 1));
+                pool.parallel_for(0, lines, grain, [&](std::size_t lo, std::size_t hi) {
+                    for (std::size_t l = lo; l < hi; ++l) {
+                        const T *a = A.data() + l * A.ld();
+                        T s = sum_lanes<T>(0, len, [a, x](std::size_t i) { return a[i] * x[i]; });
+                        y[l] = beta == T{0} ? alpha * s : alpha * s + beta * y[l];
+                    }
+                });
+            } else {
+                // op(A) 的每一列是 A 的一条连续线: 按输出分块, 每块依次累加所有线 (axpy)
+                pool.parallel_for(0, len, kAxpyBlock, [&](std::size_t lo, std::size_t hi) {
+                    for (std::size_t i = lo; i < hi; ++i)
+                        y[i] = beta == T{0} ? T{0} : beta * y[i];
+                    for (std::size_t l = 0; l < lines; ++l) {
+                        const T *a = A.data() + l * A.ld();
+                        T coef = alpha * x[l];
+                        for (std::size_t i = lo; i < hi; ++i)
+                            y[i] += coef * a[i];
+                    }
+                });
+            }
+        }
+
+        // A = A + alpha * x * y^T
+        template<typename T, Layout L>
+        void ger_kernel(T alpha, const T *x, const T *y, MatrixView<T, L> A) {
+            std::size_t lines = L == Layout::RowMajor ? A.rows() : A.cols();
+            std::size_t len = L == Layout::RowMajor ? A.cols() : A.rows();
+            // 行主序时第 l 行加上 x[l] * y, 列主序时第 l 列加上 y[l] * x
+            const T *outer = L == Layout::RowMajor ? x : y;
+            const T *inner = L == Layout::RowMajor ? y : x;
+
+            std::size_t grain = std::max<std::size_t>(1, kLevel2Grain / std::max<std::size_t>(len, 1));
+            ThreadPool::instance().parallel_for(0, lines, grain, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t l = lo; l < hi; ++l) {
+                    T *a = A.data() + l * A.ld();
+                    T coef = alpha * outer[l];
+                    for (std::size_t i = 0; i < len; ++i)
+                        a[i] += coef * inner[i];
+                }
+            });
+        }
+
+    }// namespace detail
+
+    // 矩阵向量乘法: y = alpha * op(A) * x + beta * y
+    template<MatrixLike M, typename T>
+        requires std::is_same_v<typename decltype(const_view(std::declval<M>()))::value_type, T>
+    void gemv(T alpha, const M &matrix, std::type_identity_t<std::span<const T>> x,
+              T beta, std::type_identity_t<std::span<T>> y, Op op = Op::NoTrans) {
+        auto A = const_view(matrix);
+        std::size_t rows = op == Op::NoTrans ? A.rows() : A.cols();
+        std::size_t cols = op == Op::NoTrans ? A.cols() : A.rows();
+
+        if (x.size() != cols || y.size() != rows)
+            throw std::invalid_argument("Matrix dimension mismatch.");
+
+        ALGEBRA_TRACE("gemv", rows, 1, cols, 2.0 * rows * cols, (1.0 * rows * cols + cols + 2.0 * rows) * sizeof(T));
+        if (rows == 0)
+            return;
+
+        if constexpr (detail::is_complex_v<T>) {
+            if (op == Op::ConjTrans) {
+                // A^H x = conj(A^T conj(x)), 先得到 A^T conj(x), 再共轭后与 beta * y 合并
+                std::vector<T> cx(x.size()), tmp(rows);
+                for (std::size_t i = 0; i < x.size(); ++i)
+                    cx[i] = std::conj(x[i]);
+                detail::gemv_kernel(Op::Trans, T{1}, A, cx.data(), T{0}, tmp.data());
+                for (std::size_t i = 0; i < rows; ++i)
+                    y[i] = beta == T{0} ? alpha * std::conj(tmp[i]) : alpha * std::conj(tmp[i]) + beta * y[i];
+                return;
+            }
+        }
+
+        detail::gemv_kernel(op == Op::NoTrans ? Op::NoTrans : Op::Trans, alpha, A, x.data(), beta, y.data());
+    }
+
+    // 返回 op(A) * x
+    template<MatrixLike M, typename T>
+    std::vector<T> gemv(const M &matrix, const std::vector<T> &x, Op op = Op::NoTrans) {
+        auto A = const_view(matrix);
+        std::vector<T> y(op == Op::NoTrans ? A.rows() : A.cols());
+        gemv(T{1}, matrix, x, T{0}, y, op);
+        return y;
+    }
+
+    // 秩 1 更新: A = A + alpha * x * y^T
+    template<typename T, Layout L>
+    void ger(T alpha, std::type_identity_t<std::span<const T>> x,
+             std::type_identity_t<std::span<const T>> y, MatrixView<T, L> A) {
+        if (x.size() != A.rows() || y.size() != A.cols())
+            throw std::invalid_argument("Matrix dimension mismatch.");
+
+        ALGEBRA_TRACE("ger", A.rows(), A.cols(), 1, 2.0 * A.rows() * A.cols(), 2.0 * A.rows() * A.cols() * sizeof(T));
+        if (A.empty())
+            return;
+
+        detail::ger_kernel(alpha, x.data(), y.data(), A);
+    }
+
+    template<typename T, Layout L>
+    void ger(T alpha, std::type_identity_t<std::span<const T>> x,
+             std::type_identity_t<std::span<const T>> y, Matrix<T, L> &A) {
+        ger(alpha, x, y, A.view());
+    }
+
+    // 通用矩阵乘法: C = alpha * op(A) * op(B) + beta * C, 直接累加到 C 中, 不生成中间乘积.
+    // 转置通过翻转视图的存储顺序实现, 不复制数据; C 不能与 A 或 B 重叠.
+    template<typename T, MatrixLike MA, MatrixLike MB, Layout LC>
+    void gemm(T alpha, const MA &matrixA, const MB &matrixB, T beta, MatrixView<T, LC> C,
+              Op opA = Op::NoTrans, Op opB = Op::NoTrans) {
+        auto A = const_view(matrixA);
+        auto B = const_view(matrixB);
+        static_assert(std::is_same_v<typename decltype(A)::value_type, T> &&
+                              std::is_same_v<typename decltype(B)::value_type, T>,
+                      "gemm operands must share the element type.");
+
+        std::size_t m = opA == Op::NoTrans ? A.rows() : A.cols();
+        std::size_t k = opA == Op::NoTrans ? A.cols() : A.rows();
+        std::size_t kb = opB == Op::NoTrans ? B.rows() : B.cols();
+        std::size_t n = opB == Op::NoTrans ? B.cols() : B.rows();
+
+        if (k != kb || C.rows() != m || C.cols() != n)
+            throw std::invalid_argument("Matrix dimension mismatch.");
+
+        ALGEBRA_TRACE("gemm", m, n, k, 2.0 * m * n * k, (1.0 * m * k + 1.0 * k * n + 2.0 * m * n) * sizeof(T));
+
+        // 共轭转置的复数操作数需要物化一份 O(mn) 的共轭副本, 相对 O(mnk) 的乘法可以忽略
+        constexpr bool conjugate = detail::is_complex_v<T>;
+        using HA = decltype(conj_transpose(A));
+        using HB = decltype(conj_transpose(B));
+        HA ha;
+        HB hb;
+        if (conjugate && opA == Op::ConjTrans)
+            ha = conj_transpose(A);
+        if (conjugate && opB == Op::ConjTrans)
+            hb = conj_transpose(B);
+
+        auto with_b = [&](auto a) {
+            if (opB == Op::NoTrans)
+                detail::gemm_kernel(alpha, a, B, beta, C);
+            else if (conjugate && opB == Op::ConjTrans)
+                detail::gemm_kernel(alpha, a, std::as_const(hb).view(), beta, C);
+            else
+                detail::gemm_kernel(alpha, a, transpose(B), beta, C);
+        };
+
+        if (opA == Op::NoTrans)
+            with_b(A);
+        else if (conjugate && opA == Op::ConjTrans)
+            with_b(std::as_const(ha).view());
+        else
+            with_b(transpose(A));
+    }
+
+    template<typename T, MatrixLike MA, MatrixLike MB, Layout LC>
+    void gemm(T alpha, const MA &matrixA, const MB &matrixB, T beta, Matrix<T, LC> &C,
+              Op opA = Op::NoTrans, Op opB = Op::NoTrans) {
+        gemm(alpha, matrixA, matrixB, beta, C.view(), opA, opB);
+    }
+
+    namespace detail {
+
+        // 视图在存储中覆盖的元素个数 (从首元素到最后一个元素)
+        template<typename T, Layout L>
+        std::size_t extent(MatrixView<T, L> view) {
+            if (view.empty())
+                return 0;
+            std::size_t lines = L == Layout::RowMajor ? view.rows() : view.cols();
+            std::size_t len = L == Layout::RowMajor ? view.cols() : view.rows();
+            return (lines - 1) * view.ld() + len;
+        }
+
+        // 两个视图是否共享元素. 主维度步长相同且都不跨行 (列) 时按二维矩形精确判断,
+        // 因此同一矩阵中互不相交的子块不算重叠; 其他情况按覆盖的地址区间保守判断
+        template<typename T, Layout L>
+        bool overlaps(MatrixView<T, L> a, MatrixView<T, L> b) {
+            auto begin = [](MatrixView<T, L> v) { return reinterpret_cast<std::uintptr_t>(v.data()); };
+            if (a.empty() || b.empty())
+                return false;
+            if (begin(b) < begin(a))
+                std::swap(a, b);
+            std::uintptr_t diff = begin(b) - begin(a);
+            if (diff >= extent(a) * sizeof(T))
+                return false;
+            if (a.ld() != b.ld() || diff % sizeof(T) != 0)
+                return true;
+
+            std::size_t lines_a = L == Layout::RowMajor ? a.rows() : a.cols();
+            std::size_t len_a = L == Layout::RowMajor ? a.cols() : a.rows();
+            std::size_t len_b = L == Layout::RowMajor ? b.cols() : b.rows();
+            std::size_t line = diff / sizeof(T) / a.ld(), offset = diff / sizeof(T) % a.ld();
+            if (offset + len_b > a.ld())
+                return true;
+            return line < lines_a && offset < len_a;
+        }
+
+        // 批量乘法的调度: 批量足以占满线程池时按批次并行, 每项在单个线程内做一次打包内核
+        // (打包缓冲区按线程复用, 没有逐项分配); 否则逐项执行, 由内核把输出块分给线程.
+        // item(b, parallel) 计算第 b 项
+        template<typename Item>
+        void gemm_batch(std::size_t batch, std::size_t work, Item item) {
+            auto &pool = ThreadPool::instance();
+            if (batch < pool.concurrency()) {
+                for (std::size_t b = 0; b < batch; ++b)
+                    item(b, true);
+                return;
+            }
+            std::size_t grain = std::max<std::size_t>(1, tuning().parallel_gemm / std::max<std::size_t>(work, 1));
+            pool.parallel_for(0, batch, grain, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t b = lo; b < hi; ++b)
+                    item(b, false);
+            });
+        }
+
+    }// namespace detail
+
+    // 跨步批量矩阵乘法: C_b = alpha * A_b * B_b + beta * C_b, b = 0 .. batch - 1.
+    // A, B, C 描述第 0 项的形状与主维度步长, 第 b 项从 data() + b * stride 开始.
+    // A 与 B 的步长可以小于矩阵大小 (滑动窗口) 或为 0 (所有项共用同一矩阵);
+    // 各项的 C 不能相互重叠. 转置的操作数可以用 transpose(view) 传入.
+    template<typename TA, Layout LA, typename TB, Layout LB, typename T, Layout LC>
+        requires std::is_same_v<std::remove_const_t<TA>, T> && std::is_same_v<std::remove_const_t<TB>, T>
+    void gemm_strided_batched(std::type_identity_t<T> alpha, MatrixView<TA, LA> A, std::size_t stride_a,
+                              MatrixView<TB, LB> B, std::size_t stride_b,
+                              std::type_identity_t<T> beta, MatrixView<T, LC> C, std::size_t stride_c, std::size_t batch) {
+        if (A.cols() != B.rows() || C.rows() != A.rows() || C.cols() != B.cols())
+            throw std::invalid_argument("Matrix dimension mismatch.");
+        if (batch > 1 && stride_c < detail::extent(C))
+            throw std::invalid_argument("Batched output matrices must not overlap.");
+
+        std::size_t work = C.rows() * C.cols() * std::max<std::size_t>(A.cols(), 1);
+        ALGEBRA_TRACE("gemm_strided_batched", C.rows(), C.cols(), A.cols(), 2.0 * work * batch,
+                      (1.0 * A.rows() * A.cols() + 1.0 * B.rows() * B.cols() + 2.0 * C.rows() * C.cols()) * batch * sizeof(T));
+        detail::gemm_batch(batch, work, [&](std::size_t b, bool parallel) {
+            MatrixView<const T, LA> a(A.data() + b * stride_a, A.rows(), A.cols(), A.ld());
+            MatrixView<const T, LB> bb(B.data() + b * stride_b, B.rows(), B.cols(), B.ld());
+            MatrixView<T, LC> c(C.data() + b * stride_c, C.rows(), C.cols(), C.ld());
+            detail::gemm_kernel(alpha, a, bb, beta, c, parallel);
+        });
+    }
+
+    // 连续存放的批量: 每项紧密排列, 步长等于矩阵元素数
+    template<typename TA, Layout LA, typename TB, Layout LB, typename T, Layout LC>
+        requires std::is_same_v<std::remove_const_t<TA>, T> && std::is_same_v<std::remove_const_t<TB>, T>
+    void gemm_strided_batched(std::type_identity_t<T> alpha, MatrixView<TA, LA> A, MatrixView<TB, LB> B,
+                              std::type_identity_t<T> beta, MatrixView<T, LC> C, std::size_t batch) {
+        gemm_strided_batched(alpha, A, A.rows() * A.cols(), B, B.rows() * B.cols(),
+                             beta, C, C.rows() * C.cols(), batch);
+    }
+
+    // 指针数组形式的批量乘法: 各项可以位于任意位置, 形状也可以不同;
+    // 与跨步形式相同, 各项的 C 不能相互重叠 (同一矩阵中互不相交的子块可以)
+    template<typename T, Layout LA, Layout LB, Layout LC>
+    void gemm_batched(T alpha, const std::vector<MatrixView<const T, LA>> &A, const std::vector<MatrixView<const T, LB>> &B,
+                      T beta, const std::vector<MatrixView<T, LC>> &C) {
+        if (A.size() != B.size() || A.size() != C.size())
+            throw std::invalid_argument("Batch sizes do not match.");
+
+        std::size_t work = 0;
+        double flops = 0, bytes = 0;
+        for (std::size_t b = 0; b < C.size(); ++b) {
+            if (A[b].cols() != B[b].rows() || C[b].rows() != A[b].rows() || C[b].cols() != B[b].cols())
+                throw std::invalid_argument("Matrix dimension mismatch.");
+            work = std::max(work, C[b].rows() * C[b].cols() * std::max<std::size_t>(A[b].cols(), 1));
+            flops += 2.0 * C[b].rows() * C[b].cols() * A[b].cols();
+            bytes += (1.0 * A[b].rows() * A[b].cols() + 1.0 * B[b].rows() * B[b].cols() + 2.0 * C[b].rows() * C[b].cols()) * sizeof(T);
+        }
+
+        // 按首地址排序后, 每项只需与首地址落在其地址区间内的后续项比较
+        std::vector<std::size_t> order(C.size());
+        std::iota(order.begin(), order.end(), std::size_t{0});
+        std::sort(order.begin(), order.end(), [&](std::size_t x, std::size_t y) { return std::less<>{}(C[x].data(), C[y].data()); });
+        for (std::size_t x = 0; x < order.size(); ++x) {
+            const T *end = C[order[x]].data() + detail::extent(C[order[x]]);
+            for (std::size_t y = x + 1; y < order.size() && std::less<>{}(C[order[y]].data(), end); ++y)
+                if (detail::overlaps(C[order[x]], C[order[y]]))
+                    throw std::invalid_argument("Batched output matrices must not overlap.");
+        }
+
+        // 形状按第一项记录
+        ALGEBRA_TRACE("gemm_batched", C.empty() ? 0 : C[0].rows(), C.empty() ? 0 : C[0].cols(),
+                      A.empty() ? 0 : A[0].cols(), flops, bytes);
+        detail::gemm_batch(C.size(), work, [&](std::size_t b, bool parallel) {
+            detail::gemm_kernel(alpha, A[b], B[b], beta, C[b], parallel);
+        });
+    }
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_BLAS
@@ -0,0 +1,223 @@
+#ifndef AUT_AP_2024_Spring_HW1_CHAIN
+#define AUT_AP_2024_Spring_HW1_CHAIN
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "kernel.h"
+#include "matrix.h"
+#include "thread_pool.h"
+
+namespace algebra {
+
+    // 矩阵链乘的计算顺序. dims 长度为 n + 1, 第 i 个矩阵为 dims[i] x dims[i + 1]
+    class ChainPlan {
+    public:
+        explicit ChainPlan(std::vector<std::size_t> dims)
+            : dims{std::move(dims)} {
+            if (this->dims.size() < 2)
+                throw std::invalid_argument("Matrix chain must not be empty.");
+
+            // 经典区间动态规划: cost[i][j] 为计算 A_i ... A_j 的最少标量乘法次数
+            std::size_t n = count();
+            std::vector<std::size_t> cost(n * n, 0);
+            split.assign(n * n, 0);
+
+            for (std::size_t len = 2; len <= n; ++len) {
+                for (std::size_t i = 0; i + len <= n; ++i) {
+                    std::size_t j = i + len - 1;
+                    cost[i * n + j] = std::numeric_limits<std::size_t>::max();
+                    for (std::size_t s = i; s < j; ++s) {
+                        std::size_t c = cost[i * n + s] + cost[(s + 1) * n + j] +
+                                        this->dims[i] * this->dims[s + 1] * this->dims[j + 1];
+                        if (c < cost[i * n + j]) {
+                            cost[i * n + j] = c;
+                            split[i * n + j] = s;
+                        }
+                    }
+                }
+            }
+
+            total = cost[n - 1];
+        }
+
+        // 链中矩阵个数
+        std::size_t count() const { return dims.size() - 1; }
+
+        // 最优顺序所需的标量乘法次数
+        std::size_t cost() const { return total; }
+
+        // [i, j] 区间最后一次乘法的分割点: (A_i ... A_s)(A_{s+1} ... A_j)
+        std::size_t split_at(std::size_t i, std::size_t j) const { return split[i * count() + j]; }
+
+        std::size_t rows(std::size_t i) const { return dims[i]; }
+        std::size_t cols(std::size_t j) const { return dims[j + 1]; }
+
+        // 加括号形式, 例如 "((A0A1)A2)"
+        std::string to_string() const { return to_string(0, count() - 1); }
+
+    private:
+        std::string to_string(std::size_t i, std::size_t j) const {
+            if (i == j)
+                return "A" + std::to_string(i);
+            std::size_t s = split_at(i, j);
+            return "(" + to_string(i, s) + to_string(s + 1, j) + ")";
+        }
+
+        std::vector<std::size_t> dims;
+        std::vector<std::size_t> split;
+        std::size_t total{};
+    };
+
+    namespace detail {
+
+        // 两侧子链的乘法次数都达到该值时并行计算
+        constexpr std::size_t kParallelChain = 64 * 64 * 64;
+
+        // 中间结果的缓冲区池: 释放的缓冲区被之后的阶段复用, 避免每一步重新分配
+        template<typename T>
+        class ChainWorkspace {
+        public:
+            using Buffer = std::unique_ptr<std::vector<T>>;
+
+            Buffer acquire(std::size_t size) {
+                {
+                    std::lock_guard lock{mutex};
+                    // 选择容量足够的最小缓冲区
+                    auto best = free.end();
+                    for (auto it = free.begin(); it != free.end(); ++it)
+                        if ((*it)->size() >= size && (best == free.end() || (*it)->size() < (*best)->size()))
+                            best = it;
+                    if (best != free.end()) {
+                        Buffer buffer = std::move(*best);
+                        free.erase(best);
+                        return buffer;
+                    }
+                }
+                return std::make_unique<std::vector<T>>(size);
+            }
+
+            void release(Buffer buffer) {
+                if (!buffer)
+                    return;
+                std::lock_guard lock{mutex};
+                free.push_back(std::move(buffer));
+            }
+
+        private:
+            std::mutex mutex;
+            std::vector<Buffer> free;
+        };
+
+        template<typename T, Layout L>
+        class ChainEvaluator {
+        public:
+            struct Operand {
+                MatrixView<const T, L> view;
+                typename ChainWorkspace<T>::Buffer buffer;// 输入矩阵本身时为空
+            };
+
+            ChainEvaluator(const std::vector<Matrix<T, L>> &matrices, const ChainPlan &plan)
+                : matrices{matrices}, plan{plan} {}
+
+            // 计算 [i, j] 区间的两个因子, 两侧都足够大时在线程池上并行
+            std::pair<Operand, Operand> factors(std::size_t i, std::size_t j) {
+                std::size_t s = plan.split_at(i, j);
+                Operand left, right;
+
+                bool parallel = s > i && j > s + 1 &&
+                                cost(i, s) >= kParallelChain && cost(s + 1, j) >= kParallelChain;
+
+                if (parallel) {
+                    ThreadPool::instance().parallel_for(0, 2, 1, [&](std::size_t lo, std::size_t) {
+                        if (lo == 0)
+                            left = evaluate(i, s);
+                        else
+                            right = evaluate(s + 1, j);
+                    });
+                } else {
+                    left = evaluate(i, s);
+                    right = evaluate(s + 1, j);
+                }
+
+                return {std::move(left), std::move(right)};
+            }
+
+            Operand evaluate(std::size_t i, std::size_t j) {
+                if (i == j)
+                    return {matrices[i].view(), nullptr};
+
+                auto [left, right] = factors(i, j);
+
+                std::size_t rows = plan.rows(i), cols = plan.cols(j);
+                auto buffer = workspace.acquire(rows * cols);
+                MatrixView<T, L> out{buffer->data(), rows, cols};
+                gemm_kernel(T{1}, left.view, right.view, T{0}, out);
+
+                workspace.release(std::move(left.buffer));
+                workspace.release(std::move(right.buffer));
+                return {out, std::move(buffer)};
+            }
+
+        private:
+            // [i, j] 子链最后一步乘法的规模, 用于粗略判断是否值得并行
+            std::size_t cost(std::size_t i, std::size_t j) const {
+                if (i == j)
+                    return 0;
+                std::size_t s = plan.split_at(i, j);
+                return plan.rows(i) * plan.cols(s) * plan.cols(j);
+            }
+
+            const std::vector<Matrix<T, L>> &matrices;
+            const ChainPlan &plan;
+            ChainWorkspace<T> workspace;
+        };
+
+    }// namespace detail
+
+    // 矩阵链乘: 先按形状用动态规划求出乘法次数最少的加括号方式, 再按该顺序计算.
+    // 互不依赖的子链在线程池上并行计算, 中间结果的缓冲区在各阶段之间复用.
+    template<Layout LC = Layout::RowMajor, typename T, Layout L>
+    Matrix<T, LC> multiply_chain(const std::vector<Matrix<T, L>> &matrices) {
+        if (matrices.empty())
+            throw std::invalid_argument("Matrices must not be empty.");
+
+        std::vector<std::size_t> dims{matrices[0].rows()};
+        for (std::size_t i = 0; i < matrices.size(); ++i) {
+            if (matrices[i].empty())
+                throw std::invalid_argument("Matrices must not be empty.");
+            if (matrices[i].rows() != dims.back())
+                throw std::invalid_argument("Matrix dimension mismatch.");
+            dims.push_back(matrices[i].cols());
+        }
+
+        if (matrices.size() == 1)
+            return relayout<LC>(matrices[0]);
+
+        ChainPlan plan{std::move(dims)};
+        detail::ChainEvaluator<T, L> evaluator{matrices, plan};
+
+        // 最后一次乘法直接写入结果矩阵
+        auto [left, right] = evaluator.factors(0, plan.count() - 1);
+        Matrix<T, LC> res(plan.rows(0), plan.cols(plan.count() - 1));
+        detail::gemm_kernel(T{1}, left.view, right.view, T{0}, res.view());
+
+        return res;
+    }
+
+    template<Layout LC = Layout::RowMajor, typename T, Layout L>
+    Matrix<T, LC> multiply_chain(std::initializer_list<Matrix<T, L>> matrices) {
+        return multiply_chain<LC>(std::vector<Matrix<T, L>>(matrices));
+    }
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_CHAIN
@@ -0,0 +1,317 @@
+#ifndef AUT_AP_2024_Spring_HW1_CHOLESKY
+#define AUT_AP_2024_Spring_HW1_CHOLESKY
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "instrument.h"
+#include "kernel.h"
+#include "lu.h"
+#include "matrix.h"
+#include "reduction.h"
+#include "thread_pool.h"
+
+namespace algebra {
+
+    namespace detail {
+
+        // 分块 Cholesky 的对角块大小
+        constexpr std::size_t kCholeskyBlock = 64;
+
+        // 尾部 SYRK 更新的输出块大小
+        constexpr std::size_t kCholeskyTile = 128;
+
+        // 对称正定的廉价必要条件: 方阵, 对称 (相对误差内), 对角元为正
+        template<typename T, Layout L>
+        bool spd_candidate(MatrixView<const T, L> A) {
+            if (A.rows() != A.cols())
+                return false;
+
+            std::size_t n = A.rows();
+            for (std::size_t i = 0; i < n; ++i) {
+                if (!(A(i, i) > T{0}))
+                    return false;
+                for (std::size_t j = 0; j < i; ++j) {
+                    T tol = std::numeric_limits<T>::epsilon() * 16 * (std::abs(A(i, j)) + std::abs(A(j, i)));
+                    if (std::abs(A(i, j) - A(j, i)) > tol)
+                        return false;
+                }
+            }
+            return true;
+        }
+
+    }// namespace detail
+
+    // 分块 Cholesky 分解: A = L * L^T, 只读取 A 的下三角部分.
+    // 对角块逐列分解, 下方面板逐行并行求解三角方程, 尾部矩阵按下三角输出块并行做 SYRK 更新.
+    template<typename T>
+    class Cholesky {
+    public:
+        template<MatrixLike M>
+        explicit Cholesky(const M &matrix) {
+            auto view = const_view(matrix);
+            if (view.empty())
+                throw std::invalid_argument("Matrices must not be empty.");
+            if (view.rows() != view.cols())
+                throw std::invalid_argument("Matrix must be square.");
+
+            ALGEBRA_TRACE("Cholesky", view.rows(), view.rows(), view.rows(), 1.0 / 3.0 * view.rows() * view.rows() * view.rows(),
+                          2.0 * view.rows() * view.rows() * sizeof(T));
+            l = Matrix<T>(view.rows(), view.cols());
+            detail::copy_blocked(view, l.view());
+            ok = factorize();
+        }
+
+        std::size_t size() const { return l.rows(); }
+
+        // 分解是否成功 (即矩阵数值上对称正定)
+        bool positive_definite() const { return ok; }
+
+        // 下三角因子 L (上三角部分为零)
+        const Matrix<T> &factor() const {
+            check();
+            return l;
+        }
+
+        // log(det(A)) = 2 * sum(log(L_ii)), 不会溢出
+        T log_determinant() const {
+            check();
+            T res{};
+            for (std::size_t i = 0; i < size(); ++i)
+                res += std::log(l(i, i));
+            return 2 * res;
+        }
+
+        LogDeterminant<T> slogdet() const { return {1, log_determinant()}; }
+
+        // 求解 A * X = B
+        template<Layout L>
+        Matrix<T, L> solve(const Matrix<T, L> &rhs) const {
+            check();
+            if (rhs.rows() != size())
+                throw std::invalid_argument("Matrix dimension mismatch.");
+
+            std::size_t n = size(), m = rhs.cols();
+            Matrix<T> x(n, m);
+            detail::copy_blocked(rhs.view(), x.view());
+            T *data = x.data();
+
+            // L * Y = B: 第 i 行解出后立即从其下方各行中消去 (L 的第 i 列)
+            for (std::size_t i = 0; i < n; ++i) {
+                T *row = data + i * m;
+                T d = l(i, i);
+                for (std::size_t j = 0; j < m; ++j)
+                    row[j] /= d;
+                for (std::size_t p = i + 1; p < n; ++p) {
+                    T coef = l(p, i);
+                    T *dst = data + p * m;
+                    for (std::size_t j = 0; j < m; ++j)
+                        dst[j] -= coef * row[j];
+                }
+            }
+
+            // L^T * X = Y: 第 i 行解出后从上方各行中消去 (L 的第 i 行连续)
+            for (std::size_t i = n; i-- > 0;) {
+                T *row = data + i * m;
+                T d = l(i, i);
+                for (std::size_t j = 0; j < m; ++j)
+                    row[j] /= d;
+                const T *l_row = l.data() + i * n;
+                for (std::size_t p = 0; p < i; ++p) {
+                    T coef = l_row[p];
+                    T *dst = data + p * m;
+                    for (std::size_t j = 0; j < m; ++j)
+                        dst[j] -= coef * row[j];
+                }
+            }
+
+            return relayout<L>(x);
+        }
+
+        std::vector<T> solve(const std::vector<T> &rhs) const {
+            Matrix<T> b(rhs.size(), 1);
+            std::copy(rhs.begin(), rhs.end(), b.data());
+            Matrix<T> x = solve(b);
+            return {x.data(), x.data() + x.size()};
+        }
+
+        Matrix<T> inverse() const {
+            Matrix<T> identity(size(), size());
+            for (std::size_t i = 0; i < size(); ++i)
+                identity(i, i) = T{1};
+            return solve(identity);
+        }
+
+    private:
+        void check() const {
+            if (!ok)
+                throw std::invalid_argument("Matrix is not positive definite.");
+        }
+
+        // 对角块的非分块分解, 失败 (主元非正或 NaN) 时返回 false
+        static bool factor_diagonal(T *a, std::size_t ld, std::size_t kb) {
+            for (std::size_t j = 0; j < kb; ++j) {
+                T *row_j = a + j * ld;
+                T d = row_j[j] - detail::sum_lanes<T>(0, j, [row_j](std::size_t p) { return row_j[p] * row_j[p]; });
+                if (!(d > T{0}))
+                    return false;
+                T ljj = row_j[j] = std::sqrt(d);
+                for (std::size_t i = j + 1; i < kb; ++i) {
+                    T *row_i = a + i * ld;
+                    row_i[j] = (row_i[j] - detail::sum_lanes<T>(0, j, [row_i, row_j](std::size_t p) { return row_i[p] * row_j[p]; })) / ljj;
+                }
+            }
+            return true;
+        }
+
+        bool factorize() {
+            std::size_t n = size();
+            T *a = l.data();
+            auto &pool = ThreadPool::instance();
+
+            for (std::size_t k0 = 0; k0 < n; k0 += detail::kCholeskyBlock) {
+                std::size_t kb = std::min(detail::kCholeskyBlock, n - k0);
+                T *diag = a + k0 * n + k0;
+                if (!factor_diagonal(diag, n, kb))
+                    return false;
+
+                std::size_t rest = n - k0 - kb;
+                if (rest == 0)
+                    break;
+
+                // 面板: L21 * L11^T = A21, 每一行独立地做前代
+                pool.parallel_for(k0 + kb, n, std::max<std::size_t>(1, 4096 / kb), [&](std::size_t lo, std::size_t hi) {
+                    for (std::size_t i = lo; i < hi; ++i) {
+                        T *row = a + i * n + k0;
+                        for (std::size_t j = 0; j < kb; ++j) {
+                            const T *l_row = diag + j * n;
+                            row[j] = (row[j] - detail::sum_lanes<T>(0, j, [row, l_row](std::size_t p) { return row[p] * l_row[p]; })) / l_row[j];
+                        }
+                    }
+                });
+
+                // 尾部: A22 -= L21 * L21^T, 只计算下三角的输出块
+                MatrixView<const T> panel{a + (k0 + kb) * n + k0, rest, kb, n};
+                MatrixView<T> trailing{a + (k0 + kb) * n + k0 + kb, rest, rest, n};
+                std::size_t tiles = (rest + detail::kCholeskyTile - 1) / detail::kCholeskyTile;
+                std::size_t pairs = tiles * (tiles + 1) / 2;
+
+                pool.parallel_for(0, pairs, 1, [&](std::size_t lo, std::size_t hi) {
+                    for (std::size_t t = lo; t < hi; ++t) {
+                        // 第 t 个下三角块 (bi, bj), bj <= bi
+                        std::size_t bi = 0;
+                        while ((bi + 1) * (bi + 2) / 2 <= t)
+                            ++bi;
+                        std::size_t bj = t - bi * (bi + 1) / 2;
+
+                        std::size_t i0 = bi * detail::kCholeskyTile, j0 = bj * detail::kCholeskyTile;
+                        std::size_t ib = std::min(detail::kCholeskyTile, rest - i0);
+                        std::size_t jb = std::min(detail::kCholeskyTile, rest - j0);
+                        detail::gemm_kernel(T{-1}, panel.block(i0, 0, ib, kb), transpose(panel.block(j0, 0, jb, kb)),
+                                            T{1}, trailing.block(i0, j0, ib, jb));
+                    }
+                });
+            }
+
+            // 清除上三角中的原始数据和对角块更新留下的值
+            for (std::size_t i = 0; i < n; ++i)
+                std::fill(a + i * n + i + 1, a + (i + 1) * n, T{0});
+            return true;
+        }
+
+        Matrix<T> l;
+        bool ok{false};
+    };
+
+    template<MatrixLike M>
+    Cholesky(const M &) -> Cholesky<typename decltype(const_view(std::declval<M>()))::value_type>;
+
+    // 对称矩阵求解器: 先做廉价的 SPD 检查并尝试 Cholesky, 失败时回退到部分选主元 LU
+    template<typename T>
+    class SymmetricSolver {
+    public:
+        template<MatrixLike M>
+        explicit SymmetricSolver(const M &matrix) {
+            auto view = const_view(matrix);
+            if (detail::spd_candidate(view)) {
+                Cholesky<T> chol{matrix};
+                if (chol.positive_definite()) {
+                    cholesky.emplace(std::move(chol));
+                    return;
+                }
+            }
+            lu.emplace(matrix);
+        }
+
+        // 是否使用了 Cholesky 分解
+        bool uses_cholesky() const { return cholesky.has_value(); }
+
+        template<Layout L>
+        Matrix<T, L> solve(const Matrix<T, L> &rhs) const {
+            return cholesky ? cholesky->solve(rhs) : lu->solve(rhs);
+        }
+
+        std::vector<T> solve(const std::vector<T> &rhs) const {
+            return cholesky ? cholesky->solve(rhs) : lu->solve(rhs);
+        }
+
+        Matrix<T> inverse() const {
+            return cholesky ? cholesky->inverse() : lu->inverse();
+        }
+
+        // log(det(A)), 行列式非正时抛出异常
+        T log_determinant() const {
+            if (cholesky)
+                return cholesky->log_determinant();
+
+            auto [sign, log_abs] = lu->slogdet();
+            if (sign == 0)
+                throw std::invalid_argument("Singular matrix.");
+            if (sign < 0)
+                throw std::invalid_argument("Determinant is not positive.");
+            return log_abs;
+        }
+
+        LogDeterminant<T> slogdet() const {
+            return cholesky ? cholesky->slogdet() : lu->slogdet();
+        }
+
+    private:
+        std::optional<Cholesky<T>> cholesky;
+        std::optional<LU<T>> lu;
+    };
+
+    template<MatrixLike M>
+    SymmetricSolver(const M &) -> SymmetricSolver<typename decltype(const_view(std::declval<M>()))::value_type>;
+
+    // 行列式的符号与对数绝对值, O(n^3) 且不会溢出: 对称正定时使用 Cholesky 对角线, 否则使用 LU 对角线
+    template<MatrixLike M>
+    auto slogdet(const M &matrix) {
+        using T = typename decltype(const_view(matrix))::value_type;
+        return SymmetricSolver<T>(matrix).slogdet();
+    }
+
+    template<typename T>
+    LogDeterminant<double> slogdet(const MATRIX<T> &matrix) {
+        if (matrix.empty())
+            throw std::invalid_argument("Matrices must not be empty.");
+
+        Matrix<double> converted(matrix.size(), matrix[0].size());
+        for (std::size_t i = 0; i < matrix.size(); ++i) {
+            if (matrix[i].size() != converted.cols())
+                throw std::invalid_argument("Matrix dimension mismatch.");
+            for (std::size_t j = 0; j < converted.cols(); ++j)
+                converted(i, j) = static_cast<double>(matrix[i][j]);
+        }
+        return slogdet(converted);
+    }
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_CHOLESKY
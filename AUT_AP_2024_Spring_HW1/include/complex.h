@@ -0,0 +1,64 @@
+#ifndef AUT_AP_2024_Spring_HW1_COMPLEX
+#define AUT_AP_2024_Spring_HW1_COMPLEX
+
+#include <complex>
+#include <cstddef>
+
+#include "matrix.h"
+
+namespace algebra {
+
+    namespace detail {
+
+        // 复数取共轭, 实数原样返回
+        template<typename T>
+        T conj_value(const T &x) {
+            if constexpr (is_complex_v<T>)
+                return std::conj(x);
+            else
+                return x;
+        }
+
+    }// namespace detail
+
+    // 逐元素共轭, 保持存储顺序
+    template<MatrixLike M>
+    auto conj(const M &matrix) {
+        auto view = const_view(matrix);
+        using T = typename decltype(view)::value_type;
+        constexpr Layout L = decltype(view)::layout;
+
+        Matrix<T, L> res(view.rows(), view.cols());
+        std::size_t lines = L == Layout::RowMajor ? view.rows() : view.cols();
+        std::size_t len = L == Layout::RowMajor ? view.cols() : view.rows();
+        T *dst = res.data();
+        for (std::size_t l = 0; l < lines; ++l) {
+            const T *src = view.data() + l * view.ld();
+            for (std::size_t p = 0; p < len; ++p)
+                dst[l * len + p] = detail::conj_value(src[p]);
+        }
+        return res;
+    }
+
+    // 共轭转置 A^H: 结果的存储顺序与输入相反, 元素在内存中的次序不变, 只需一次顺序扫描
+    template<MatrixLike M>
+    auto conj_transpose(const M &matrix) {
+        return transpose(conj(matrix));
+    }
+
+    // 是否为 Hermite 矩阵 (实数时即对称矩阵)
+    template<MatrixLike M>
+    bool is_hermitian(const M &matrix) {
+        auto view = const_view(matrix);
+        if (view.rows() != view.cols())
+            return false;
+        for (std::size_t i = 0; i < view.rows(); ++i)
+            for (std::size_t j = 0; j <= i; ++j)
+                if (view(i, j) != detail::conj_value(view(j, i)))
+                    return false;
+        return true;
+    }
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_COMPLEX
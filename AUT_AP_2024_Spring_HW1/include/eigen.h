@@ -0,0 +1,368 @@
+#ifndef AUT_AP_2024_Spring_HW1_EIGEN
+#define AUT_AP_2024_Spring_HW1_EIGEN
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "blas.h"
+#include "instrument.h"
+#include "kernel.h"
+#include "matrix.h"
+#include "qr.h"
+#include "reduction.h"
+#include "thread_pool.h"
+
+namespace algebra {
+
+    namespace detail {
+
+        // 一次 QL 扫描中记录的 Givens 旋转, 作用于第 i 与 i + 1 个特征向量
+        template<typename T>
+        struct Rotation {
+            std::size_t i;
+            T c, s;
+        };
+
+        // 旋转作用到特征向量时每个并行块负责的分量数
+        constexpr std::size_t kRotationGrain = 256;
+
+    }// namespace detail
+
+    // 对称矩阵的特征分解: A = Z * diag(w) * Z^T.
+    // 先用 Householder 变换约化为三对角矩阵 (对称秩 2 更新使用 gemv/ger 内核),
+    // 再用带隐式 Wilkinson 位移的 QL 迭代求三对角矩阵的特征值.
+    // 特征向量按行保存, 每次扫描的旋转序列按分量分块并行地作用到所有向量上.
+    template<typename T>
+    class SymmetricEigen {
+    public:
+        template<MatrixLike M>
+        explicit SymmetricEigen(const M &matrix, bool compute_vectors = true)
+            : with_vectors{compute_vectors} {
+            auto view = const_view(matrix);
+            if (view.empty())
+                throw std::invalid_argument("Matrices must not be empty.");
+            if (view.rows() != view.cols())
+                throw std::invalid_argument("Matrix must be square.");
+
+            std::size_t n = view.rows();
+            // 三对角化 4/3 n^3, 累积特征向量再约 (4/3 + 6) n^3 (QL 迭代按每个特征值 2 次扫描估计)
+            ALGEBRA_TRACE("SymmetricEigen", n, n, n, (with_vectors ? 9.0 : 4.0 / 3.0) * n * n * n, 2.0 * n * n * sizeof(T));
+            Matrix<T> a(n, n);
+            detail::copy_blocked(view, a.view());
+
+            std::vector<T> tau;
+            tridiagonalize(a, tau);
+            if (with_vectors)
+                accumulate(a, tau);
+            iterate();
+            sort();
+        }
+
+        std::size_t size() const { return w.size(); }
+
+        // 升序排列的特征值
+        const std::vector<T> &values() const { return w; }
+
+        // 第 j 列为 values()[j] 对应的单位特征向量
+        Matrix<T, Layout::ColMajor> vectors() const {
+            if (!with_vectors)
+                throw std::invalid_argument("Eigenvectors were not computed.");
+            return transpose(z);
+        }
+
+    private:
+        // Householder 三对角化: 第 k 步消去第 k 行 (列) 中 k + 1 之后的元素.
+        // 反射子 v 的尾部保存在第 k 行的 k + 2 之后, 主对角线与次对角线写入 w 与 e.
+        void tridiagonalize(Matrix<T> &a, std::vector<T> &tau) {
+            std::size_t n = a.rows();
+            T *data = a.data();
+            w.resize(n);
+            e.assign(n, T{0});
+            tau.assign(n, T{0});
+            std::vector<T> v(n), p(n);
+
+            for (std::size_t k = 0; k + 2 < n; ++k) {
+                T *x = data + k * n + k + 1;
+                std::size_t len = n - k - 1;
+                T tail = detail::sum_lanes<T>(1, len, [x](std::size_t i) { return x[i] * x[i]; });
+
+                w[k] = data[k * n + k];
+                if (tail == T{0}) {
+                    e[k] = x[0];
+                    continue;
+                }
+
+                T alpha = x[0];
+                T beta = -std::copysign(std::sqrt(alpha * alpha + tail), alpha);
+                T scale = T{1} / (alpha - beta);
+                v[0] = T{1};
+                for (std::size_t i = 1; i < len; ++i)
+                    v[i] = x[i] *= scale;
+                x[0] = beta;
+                e[k] = beta;
+                T t = tau[k] = (beta - alpha) / beta;
+
+                // A22 = H * A22 * H: p = tau * A22 * v, q = p - (tau / 2) (p^T v) v, A22 -= v q^T + q v^T
+                MatrixView<T> trailing{data + (k + 1) * n + k + 1, len, len, n};
+                detail::gemv_kernel(Op::NoTrans, t, MatrixView<const T>(trailing), v.data(), T{0}, p.data());
+                T pv = detail::sum_lanes<T>(0, len, [&](std::size_t i) { return p[i] * v[i]; });
+                T half = t * pv / 2;
+                for (std::size_t i = 0; i < len; ++i)
+                    p[i] -= half * v[i];
+                detail::ger_kernel(T{-1}, v.data(), p.data(), trailing);
+                detail::ger_kernel(T{-1}, p.data(), v.data(), trailing);
+            }
+
+            if (n >= 2) {
+                w[n - 2] = data[(n - 2) * n + n - 2];
+                e[n - 2] = data[(n - 2) * n + n - 1];
+            }
+            w[n - 1] = data[(n - 1) * n + n - 1];
+        }
+
+        // 逆序累积 Q = H_0 H_1 ... H_{n-3}, 并以 Q^T 作为特征向量 (按行) 的初值
+        void accumulate(const Matrix<T> &a, const std::vector<T> &tau) {
+            std::size_t n = a.rows();
+            Matrix<T> q(n, n);
+            for (std::size_t i = 0; i < n; ++i)
+                q(i, i) = T{1};
+
+            const T *data = a.data();
+            T *qd = q.data();
+            std::vector<T> v(n), u(n);
+            for (std::size_t k = n < 2 ? 0 : n - 2; k-- > 0;) {
+                if (tau[k] == T{0})
+                    continue;
+                std::size_t len = n - k - 1;
+                v[0] = T{1};
+                std::copy(data + k * n + k + 2, data + (k + 1) * n, v.begin() + 1);
+
+                // Q22 = Q22 - tau * v * (v^T Q22)
+                MatrixView<T> block{qd + (k + 1) * n + k + 1, len, len, n};
+                detail::gemv_kernel(Op::Trans, T{1}, MatrixView<const T>(block), v.data(), T{0}, u.data());
+                detail::ger_kernel(-tau[k], v.data(), u.data(), block);
+            }
+
+            // Q 的列即 Q^T 的行
+            z = relayout<Layout::RowMajor>(transpose(std::move(q)));
+        }
+
+        // 带隐式位移的对称三对角 QL 迭代 (EISPACK tql2)
+        void iterate() {
+            std::size_t n = size();
+            T f{}, tst = 0;
+            const T eps = std::numeric_limits<T>::epsilon();
+            std::vector<detail::Rotation<T>> sweep;
+
+            for (std::size_t l = 0; l < n; ++l) {
+                tst = std::max(tst, std::abs(w[l]) + std::abs(e[l]));
+                std::size_t m = l;
+                while (m + 1 < n && std::abs(e[m]) > eps * tst)
+                    ++m;
+
+                if (m > l) {
+                    std::size_t iterations = 0;
+                    do {
+                        if (++iterations > 64 * n)
+                            throw std::invalid_argument("Eigenvalue iteration did not converge.");
+
+                        T g = w[l];
+                        T p = (w[l + 1] - g) / (2 * e[l]);
+                        T r = std::copysign(std::hypot(p, T{1}), p);
+                        w[l] = e[l] / (p + r);
+                        w[l + 1] = e[l] * (p + r);
+                        T dl1 = w[l + 1];
+                        T h = g - w[l];
+                        for (std::size_t i = l + 2; i < n; ++i)
+                            w[i] -= h;
+                        f += h;
+
+                        p = w[m];
+                        T c = 1, c2 = 1, c3 = 1, s = 0, s2 = 0;
+                        T el1 = e[l + 1];
+                        sweep.clear();
+                        for (std::size_t i = m; i-- > l;) {
+                            c3 = c2;
+                            c2 = c;
+                            s2 = s;
+                            g = c * e[i];
+                            h = c * p;
+                            r = std::hypot(p, e[i]);
+                            e[i + 1] = s * r;
+                            s = e[i] / r;
+                            c = p / r;
+                            p = c * w[i] - s * g;
+                            w[i + 1] = h + s * (c * g + s * w[i]);
+                            if (with_vectors)
+                                sweep.push_back({i, c, s});
+                        }
+                        p = -s * s2 * c3 * el1 * e[l] / dl1;
+                        e[l] = s * p;
+                        w[l] = c * p;
+
+                        if (with_vectors)
+                            rotate(sweep);
+                    } while (std::abs(e[l]) > eps * tst);
+                }
+
+                w[l] += f;
+                e[l] = T{0};
+            }
+        }
+
+        // 按顺序把一次扫描的全部旋转作用到特征向量上, 不同分量互不依赖
+        void rotate(const std::vector<detail::Rotation<T>> &sweep) {
+            std::size_t n = size();
+            T *data = z.data();
+            ThreadPool::instance().parallel_for(0, n, detail::kRotationGrain, [&](std::size_t lo, std::size_t hi) {
+                for (const auto &[i, c, s]: sweep) {
+                    T *zi = data + i * n, *zj = data + (i + 1) * n;
+                    for (std::size_t k = lo; k < hi; ++k) {
+                        T h = zj[k];
+                        zj[k] = s * zi[k] + c * h;
+                        zi[k] = c * zi[k] - s * h;
+                    }
+                }
+            });
+        }
+
+        void sort() {
+            std::size_t n = size();
+            std::vector<std::size_t> order(n);
+            std::iota(order.begin(), order.end(), std::size_t{0});
+            std::stable_sort(order.begin(), order.end(), [this](std::size_t x, std::size_t y) { return w[x] < w[y]; });
+
+            std::vector<T> sorted(n);
+            for (std::size_t i = 0; i < n; ++i)
+                sorted[i] = w[order[i]];
+            w = std::move(sorted);
+
+            if (with_vectors) {
+                Matrix<T> res(n, n);
+                const T *src = std::as_const(z).data();
+                T *dst = res.data();
+                for (std::size_t i = 0; i < n; ++i)
+                    std::copy_n(src + order[i] * n, n, dst + i * n);
+                z = std::move(res);
+            }
+        }
+
+        bool with_vectors;
+        std::vector<T> w;// 特征值 (迭代时为三对角矩阵的主对角线)
+        std::vector<T> e;// 次对角线, e[i] 连接 i 与 i + 1
+        Matrix<T> z;     // 第 i 行为第 i 个特征向量
+    };
+
+    template<MatrixLike M>
+    SymmetricEigen(const M &, bool = true) -> SymmetricEigen<typename decltype(const_view(std::declval<M>()))::value_type>;
+
+    // 只求对称矩阵的特征值 (升序), 省去特征向量的累积与旋转
+    template<MatrixLike M>
+    auto eigenvalues(const M &matrix) {
+        return SymmetricEigen(matrix, false).values();
+    }
+
+    struct PowerOptions {
+        std::size_t oversample = 8;    // 子空间比 k 多出的列数, 加快收敛
+        std::size_t max_iterations = 1000;
+        double tolerance = 1e-10;      // 相对残差 ||A x - lambda x|| / |lambda_max|
+        unsigned seed = 0;             // 初始子空间的随机种子
+    };
+
+    template<typename T>
+    struct EigenPairs {
+        std::vector<T> values;               // 按绝对值降序
+        Matrix<T, Layout::ColMajor> vectors; // n x k, 第 j 列对应 values[j]
+        std::size_t iterations{};
+        bool converged{};
+    };
+
+    // 块幂迭代 (子空间迭代 + Rayleigh-Ritz) 求绝对值最大的 k 个特征对.
+    // 每次迭代只需一次 A 与 n x b 块的 GEMM, 其余操作均为 O(n * b^2).
+    template<MatrixLike M>
+    auto dominant_eigenpairs(const M &matrix, std::size_t k, PowerOptions opts = {}) {
+        auto A = const_view(matrix);
+        using T = typename decltype(A)::value_type;
+        using ColMatrix = Matrix<T, Layout::ColMajor>;
+
+        if (A.empty())
+            throw std::invalid_argument("Matrices must not be empty.");
+        if (A.rows() != A.cols())
+            throw std::invalid_argument("Matrix must be square.");
+        std::size_t n = A.rows();
+        if (k == 0 || k > n)
+            throw std::invalid_argument("Invalid number of eigenpairs.");
+
+        std::size_t b = std::min(n, k + opts.oversample);
+
+        ColMatrix x(n, b), ax(n, b);
+        std::mt19937 gen(opts.seed);
+        std::normal_distribution<double> dist;
+        for (std::size_t i = 0; i < x.size(); ++i)
+            x.data()[i] = static_cast<T>(dist(gen));
+        x = QR<T>(x).q();
+        detail::gemm_kernel(T{1}, A, std::as_const(x).view(), T{0}, ax.view());
+
+        EigenPairs<T> res;
+        std::vector<std::size_t> order(b);
+        ColMatrix h(b, b), scratch(n, b);
+
+        for (res.iterations = 1;; ++res.iterations) {
+            // Rayleigh-Ritz: H = X^T A X, 旋转 X 与 A X 到 Ritz 向量
+            detail::gemm_kernel(T{1}, transpose(std::as_const(x).view()), std::as_const(ax).view(), T{0}, h.view());
+            for (std::size_t i = 0; i < b; ++i)
+                for (std::size_t j = 0; j < i; ++j)
+                    h(i, j) = h(j, i) = (h(i, j) + h(j, i)) / 2;
+            SymmetricEigen<T> ritz(h);
+            auto W = ritz.vectors();
+            const auto &theta = ritz.values();
+
+            detail::gemm_kernel(T{1}, std::as_const(x).view(), std::as_const(W).view(), T{0}, scratch.view());
+            std::swap(x, scratch);
+            detail::gemm_kernel(T{1}, std::as_const(ax).view(), std::as_const(W).view(), T{0}, scratch.view());
+            std::swap(ax, scratch);
+
+            std::iota(order.begin(), order.end(), std::size_t{0});
+            std::stable_sort(order.begin(), order.end(),
+                             [&](std::size_t p, std::size_t q) { return std::abs(theta[p]) > std::abs(theta[q]); });
+
+            // 前 k 个 Ritz 对的残差
+            T scale = std::max(std::abs(theta[order[0]]), std::numeric_limits<T>::min());
+            res.converged = true;
+            for (std::size_t j = 0; j < k && res.converged; ++j) {
+                std::size_t c = order[j];
+                const T *xc = std::as_const(x).data() + c * n;
+                const T *axc = std::as_const(ax).data() + c * n;
+                T r = detail::sum_lanes<T>(0, n, [&](std::size_t i) {
+                    T d = axc[i] - theta[c] * xc[i];
+                    return d * d;
+                });
+                res.converged = std::sqrt(r) <= static_cast<T>(opts.tolerance) * scale;
+            }
+
+            if (res.converged || res.iterations >= opts.max_iterations) {
+                res.values.resize(k);
+                res.vectors = ColMatrix(n, k);
+                for (std::size_t j = 0; j < k; ++j) {
+                    res.values[j] = theta[order[j]];
+                    std::copy_n(std::as_const(x).data() + order[j] * n, n, res.vectors.data() + j * n);
+                }
+                return res;
+            }
+
+            // 幂迭代一步: X = orth(A X), 再计算新的 A X
+            x = QR<T>(ax).q();
+            detail::gemm_kernel(T{1}, A, std::as_const(x).view(), T{0}, ax.view());
+        }
+    }
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_EIGEN
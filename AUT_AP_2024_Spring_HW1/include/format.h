@@ -0,0 +1,163 @@
+#ifndef AUT_AP_2024_Spring_HW1_FORMAT
+#define AUT_AP_2024_Spring_HW1_FORMAT
+
+#include <algorithm>
+#include <charconv>
+#include <complex>
+#include <cstddef>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace algebra {
+
+    // 元素在单元格内的对齐方式
+    enum class Align { Left,
+                       Center,
+                       Right };
+
+    struct FormatOptions {
+        int width = 7;             // 单元格最小宽度, 内容更长时不截断
+        int precision = -1;        // 浮点数的小数位数, 负数表示最短的往返表示
+        bool scientific = false;   // 浮点数使用科学计数法
+        Align align = Align::Center;
+        char separator = '|';
+        std::size_t edge_items = 0;// 非零时, 超过 2 * edge_items 的行 (列) 只输出首尾各 edge_items 个, 中间以 "..." 代替
+    };
+
+    // 缓冲的矩阵文本格式化器: 元素用 std::to_chars 直接写入可复用的大缓冲区,
+    // 缓冲区将满时整块写出到流, 不为每个元素或每行构造字符串, 也不逐行刷新.
+    class MatrixFormatter {
+    public:
+        static constexpr std::size_t kBufferSize = std::size_t{1} << 16;
+
+        explicit MatrixFormatter(FormatOptions options = {})
+            : opts{options} { buffer.reserve(kBufferSize); }
+
+        const FormatOptions &options() const { return opts; }
+
+        // get(i, j) 返回第 i 行第 j 列的元素
+        template<typename Get>
+        void write(std::ostream &out, std::size_t rows, std::size_t cols, Get get) {
+            sink = &out;
+            auto row_ids = pick(rows), col_ids = pick(cols);
+
+            for (std::size_t r: row_ids) {
+                for (std::size_t c: col_ids) {
+                    reserve();
+                    buffer.push_back(opts.separator);
+                    if (r == kEllipsis || c == kEllipsis)
+                        pad("...", 3);
+                    else
+                        cell(get(r, c));
+                }
+                buffer.push_back(opts.separator);
+                buffer.push_back('\n');
+            }
+            flush();
+            sink = nullptr;
+        }
+
+        // 格式化为字符串, 便于测试与日志
+        template<typename Get>
+        std::string to_string(std::size_t rows, std::size_t cols, Get get) {
+            std::ostringstream out;
+            write(out, rows, cols, get);
+            return std::move(out).str();
+        }
+
+    private:
+        static constexpr std::size_t kEllipsis = static_cast<std::size_t>(-1);
+
+        // 单个分量的最大长度, 超出时 (如大数的定点表示) 改用科学计数法
+        static constexpr std::size_t kPartMax = 128;
+
+        // 单个元素的最大长度 (复数的两个分量加上符号与 'i')
+        static constexpr std::size_t kCellMax = 2 * kPartMax + 2;
+
+        // 需要输出的下标, kEllipsis 表示省略号
+        std::vector<std::size_t> pick(std::size_t n) const {
+            std::vector<std::size_t> ids;
+            std::size_t e = opts.edge_items;
+            if (e == 0 || n <= 2 * e) {
+                ids.resize(n);
+                for (std::size_t i = 0; i < n; ++i)
+                    ids[i] = i;
+                return ids;
+            }
+            for (std::size_t i = 0; i < e; ++i)
+                ids.push_back(i);
+            ids.push_back(kEllipsis);
+            for (std::size_t i = n - e; i < n; ++i)
+                ids.push_back(i);
+            return ids;
+        }
+
+        void reserve() {
+            std::size_t need = static_cast<std::size_t>(std::max(opts.width, 0)) + kCellMax + 2;
+            if (buffer.size() + need > kBufferSize)
+                flush();
+        }
+
+        void flush() {
+            if (sink && !buffer.empty())
+                sink->write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            buffer.clear();
+        }
+
+        // 把 x 写入 [first, last), 返回写入的末尾
+        template<typename T>
+        char *render(char *first, char *last, const T &x) const {
+            if constexpr (std::is_floating_point_v<T>) {
+                last = std::min(last, first + kPartMax);
+                std::chars_format fmt = opts.scientific ? std::chars_format::scientific : std::chars_format::fixed;
+                auto res = opts.precision < 0
+                                   ? (opts.scientific ? std::to_chars(first, last, x, fmt) : std::to_chars(first, last, x))
+                                   : std::to_chars(first, last, x, fmt, opts.precision);
+                if (res.ec != std::errc{})
+                    res = std::to_chars(first, last, x, std::chars_format::scientific, std::min(opts.precision, 32));
+                return res.ptr;
+            } else if constexpr (std::is_same_v<T, bool>) {
+                return std::copy_n(x ? "true" : "false", x ? 4 : 5, first);
+            } else if constexpr (std::is_integral_v<T>) {
+                return std::to_chars(first, last, x).ptr;
+            } else {
+                // std::complex: a+bi
+                char *p = render(first, last, x.real());
+                if (!(x.imag() < 0))
+                    *p++ = '+';
+                p = render(p, last, x.imag());
+                *p++ = 'i';
+                return p;
+            }
+        }
+
+        template<typename T>
+        void cell(const T &x) {
+            char scratch[kCellMax];
+            char *end = render(scratch, scratch + kCellMax, x);
+            pad(scratch, static_cast<std::size_t>(end - scratch));
+        }
+
+        // 按对齐方式填充到 width; 居中时多出的空格放在右侧
+        void pad(const char *text, std::size_t len) {
+            std::size_t width = static_cast<std::size_t>(std::max(opts.width, 0));
+            std::size_t fill = width > len ? width - len : 0;
+            std::size_t left = opts.align == Align::Left ? 0 : opts.align == Align::Right ? fill : fill / 2;
+            buffer.append(left, ' ');
+            buffer.append(text, len);
+            buffer.append(fill - left, ' ');
+        }
+
+        FormatOptions opts;
+        std::string buffer;
+        std::ostream *sink{};
+    };
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_FORMAT
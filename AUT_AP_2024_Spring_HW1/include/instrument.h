@@ -0,0 +1,168 @@
+#ifndef AUT_AP_2024_Spring_HW1_INSTRUMENT
+#define AUT_AP_2024_Spring_HW1_INSTRUMENT
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+
+namespace algebra::instrument {
+
+    // 是否在编译时打开了插桩 (-DALGEBRA_INSTRUMENT, 或 CMake 选项 ALGEBRA_INSTRUMENT)
+#ifdef ALGEBRA_INSTRUMENT
+    inline constexpr bool enabled = true;
+#else
+    inline constexpr bool enabled = false;
+#endif
+
+    // 一次运算调用: 形状为 m x k 乘 k x n (逐元素运算 k = 1, 方阵分解 m = n = k)
+    struct Event {
+        const char *op;
+        std::size_t m, n, k;
+        double flops;     // 浮点运算次数 (估计值)
+        double bytes;     // 读写的矩阵数据字节数 (估计值)
+        double seconds;   // 墙钟时间
+    };
+
+    // 形状直方图的桶: 每一维向上取整到 2 的幂
+    using ShapeBucket = std::array<std::size_t, 3>;
+
+    struct OpStats {
+        std::size_t calls{};
+        double flops{}, bytes{}, seconds{};
+        std::map<ShapeBucket, std::size_t> shapes;
+    };
+
+    using Sink = std::function<void(const Event &)>;
+
+    // 全局统计: 按运算名汇总, 并把每个事件转发给可选的 sink
+    class Registry {
+    public:
+        static Registry &instance() {
+            static Registry registry;
+            return registry;
+        }
+
+        void record(const Event &event) {
+            Sink forward;
+            {
+                std::lock_guard lock{mutex};
+                OpStats &s = stats[event.op];
+                ++s.calls;
+                s.flops += event.flops;
+                s.bytes += event.bytes;
+                s.seconds += event.seconds;
+                ++s.shapes[{std::bit_ceil(event.m), std::bit_ceil(event.n), std::bit_ceil(event.k)}];
+                forward = sink;
+            }
+            if (forward)
+                forward(event);
+        }
+
+        // sink 在记录事件的线程中调用, 需要自行保证线程安全; 传入空函数取消
+        void set_sink(Sink s) {
+            std::lock_guard lock{mutex};
+            sink = std::move(s);
+        }
+
+        std::map<std::string, OpStats> snapshot() const {
+            std::lock_guard lock{mutex};
+            return stats;
+        }
+
+        void reset() {
+            std::lock_guard lock{mutex};
+            stats.clear();
+        }
+
+        // 按总耗时从高到低输出每个运算的调用次数, 耗时, GFLOP/s, 带宽和形状分布
+        void report(std::ostream &out) const {
+            if (!enabled) {
+                out << "algebra instrumentation is disabled (build with ALGEBRA_INSTRUMENT)\n";
+                return;
+            }
+            std::multimap<double, std::pair<std::string, OpStats>, std::greater<>> order;
+            for (auto &[name, s]: snapshot())
+                order.emplace(s.seconds, std::pair{name, s});
+
+            char line[160];
+            std::snprintf(line, sizeof line, "%-24s %10s %12s %10s %10s\n", "operation", "calls", "time (ms)", "GFLOP/s", "GB/s");
+            out << line;
+            for (auto &[seconds, entry]: order) {
+                auto &[name, s] = entry;
+                double rate = seconds > 0 ? 1e-9 / seconds : 0;
+                std::snprintf(line, sizeof line, "%-24s %10zu %12.3f %10.2f %10.2f\n", name.c_str(), s.calls,
+                              seconds * 1e3, s.flops * rate, s.bytes * rate);
+                out << line;
+                for (auto &[shape, count]: s.shapes) {
+                    std::snprintf(line, sizeof line, "    <=%zux%zux%zu: %zu\n", shape[0], shape[1], shape[2], count);
+                    out << line;
+                }
+            }
+        }
+
+    private:
+        Registry() = default;
+
+        mutable std::mutex mutex;
+        std::map<std::string, OpStats> stats;
+        Sink sink;
+    };
+
+    inline void set_sink(Sink sink) { Registry::instance().set_sink(std::move(sink)); }
+    inline std::map<std::string, OpStats> snapshot() { return Registry::instance().snapshot(); }
+    inline void reset() { Registry::instance().reset(); }
+    inline void report(std::ostream &out) { Registry::instance().report(out); }
+
+    // 计时并在析构时记录一次调用. 只记录最外层的调用: 运算内部调用的其他公开函数
+    // (如 inverse 调用 LU::solve, determinant 的递归) 的时间计入外层运算
+    class Scope {
+    public:
+        Scope(const char *op, std::size_t m, std::size_t n, std::size_t k, double flops, double bytes)
+            : event{op, m, n, k, flops, bytes, 0}, outermost{depth()++ == 0},
+              start{outermost ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{}} {}
+
+        ~Scope() {
+            --depth();
+            if (!outermost)
+                return;
+            event.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            Registry::instance().record(event);
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        static std::size_t &depth() {
+            thread_local std::size_t d = 0;
+            return d;
+        }
+
+        Event event;
+        bool outermost;
+        std::chrono::steady_clock::time_point start;
+    };
+
+}// namespace algebra::instrument
+
+// 在公开函数入口处记录调用; 未定义 ALGEBRA_INSTRUMENT 时展开为空, 参数不被求值
+#ifdef ALGEBRA_INSTRUMENT
+#define ALGEBRA_INSTRUMENT_CONCAT_(a, b) a##b
+#define ALGEBRA_INSTRUMENT_NAME_(line) ALGEBRA_INSTRUMENT_CONCAT_(algebra_instrument_scope_, line)
+#define ALGEBRA_TRACE(op, m, n, k, flops, bytes)                                               \
+    ::algebra::instrument::Scope ALGEBRA_INSTRUMENT_NAME_(__LINE__)(                           \
+            op, static_cast<std::size_t>(m), static_cast<std::size_t>(n), static_cast<std::size_t>(k), \
+            static_cast<double>(flops), static_cast<double>(bytes))
+#else
+#define ALGEBRA_TRACE(op, m, n, k, flops, bytes) static_cast<void>(0)
+#endif
+
+#endif// AUT_AP_2024_Spring_HW1_INSTRUMENT
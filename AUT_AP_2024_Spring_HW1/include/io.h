@@ -0,0 +1,550 @@
+#ifndef AUT_AP_2024_Spring_HW1_IO
+#define AUT_AP_2024_Spring_HW1_IO
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ALGEBRA_HAS_MMAP 1
+#else
+#include <fstream>
+#include <sstream>
+#endif
+
+#include "complex.h"
+#include "matrix.h"
+#include "sparse.h"
+#include "thread_pool.h"
+
+namespace algebra {
+
+    namespace detail {
+
+        // 每个解析任务至少处理的字节数; 块在行边界处切分
+        inline constexpr std::size_t kParseChunk = std::size_t{1} << 22;
+
+        // 只读映射整个文件; 没有 mmap 的平台退化为一次性读入内存
+        class MappedFile {
+        public:
+            explicit MappedFile(const std::string &path) {
+#ifdef ALGEBRA_HAS_MMAP
+                int fd = ::open(path.c_str(), O_RDONLY);
+                if (fd < 0)
+                    throw std::runtime_error("Cannot open file: " + path);
+                struct stat st {};
+                if (::fstat(fd, &st) != 0) {
+                    ::close(fd);
+                    throw std::runtime_error("Cannot stat file: " + path);
+                }
+                size_ = static_cast<std::size_t>(st.st_size);
+                if (size_) {
+                    void *p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (p == MAP_FAILED) {
+                        ::close(fd);
+                        throw std::runtime_error("Cannot map file: " + path);
+                    }
+                    ::madvise(p, size_, MADV_SEQUENTIAL);
+                    data_ = static_cast<const char *>(p);
+                }
+                ::close(fd);
+#else
+                std::ifstream in(path, std::ios::binary);
+                if (!in)
+                    throw std::runtime_error("Cannot open file: " + path);
+                std::ostringstream buffer;
+                buffer << in.rdbuf();
+                contents = std::move(buffer).str();
+                data_ = contents.data();
+                size_ = contents.size();
+#endif
+            }
+
+            ~MappedFile() {
+#ifdef ALGEBRA_HAS_MMAP
+                if (data_)
+                    ::munmap(const_cast<char *>(data_), size_);
+#endif
+            }
+
+            MappedFile(const MappedFile &) = delete;
+            MappedFile &operator=(const MappedFile &) = delete;
+
+            std::string_view text() const { return {data_, size_}; }
+
+        private:
+            const char *data_{};
+            std::size_t size_{};
+#ifndef ALGEBRA_HAS_MMAP
+            std::string contents;
+#endif
+        };
+
+        inline bool is_blank(char c) { return c == ' ' || c == '\t'; }
+
+        // 对 [lo, hi) 中的每一行调用 fn(line), 行尾的 '\r' 已去除
+        template<typename F>
+        void for_each_line(std::string_view text, std::size_t lo, std::size_t hi, F &&fn) {
+            const char *p = text.data() + lo, *end = text.data() + hi;
+            while (p < end) {
+                auto *nl = static_cast<const char *>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+                const char *line_end = nl ? nl : end;
+                std::size_t len = static_cast<std::size_t>(line_end - p);
+                if (len && p[len - 1] == '\r')
+                    --len;
+                fn(std::string_view(p, len));
+                p = nl ? nl + 1 : end;
+            }
+        }
+
+        // 有效记录: 非空白行, 且不以注释符开头 (comment 为 0 时不识别注释)
+        inline bool is_record(std::string_view line, char comment) {
+            std::size_t i = 0;
+            while (i < line.size() && is_blank(line[i]))
+                ++i;
+            return i < line.size() && (comment == 0 || line[i] != comment);
+        }
+
+        // 文本按行切块后每块的记录数; first[c] 为第 c 块第一条记录的全局序号
+        struct RecordIndex {
+            std::vector<std::size_t> bounds;// 块边界, 共 chunks + 1 个
+            std::vector<std::size_t> first; // 共 chunks + 1 个, 最后一个为记录总数
+            std::size_t total() const { return first.back(); }
+        };
+
+        inline RecordIndex index_records(std::string_view text, char comment) {
+            std::size_t workers = ThreadPool::instance().concurrency();
+            std::size_t target = std::max(kParseChunk, text.size() / (4 * workers) + 1);
+
+            RecordIndex index;
+            index.bounds.push_back(0);
+            while (index.bounds.back() < text.size()) {
+                std::size_t pos = std::min(index.bounds.back() + target, text.size());
+                if (pos < text.size()) {
+                    std::size_t nl = text.find('\n', pos);
+                    pos = nl == std::string_view::npos ? text.size() : nl + 1;
+                }
+                index.bounds.push_back(pos);
+            }
+
+            std::size_t chunks = index.bounds.size() - 1;
+            index.first.assign(chunks + 1, 0);
+            ThreadPool::instance().parallel_for(0, chunks, 1, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t c = lo; c < hi; ++c) {
+                    std::size_t count = 0;
+                    for_each_line(text, index.bounds[c], index.bounds[c + 1],
+                                  [&](std::string_view line) { count += is_record(line, comment); });
+                    index.first[c + 1] = count;
+                }
+            });
+            for (std::size_t c = 0; c < chunks; ++c)
+                index.first[c + 1] += index.first[c];
+            return index;
+        }
+
+        // 并行地对每条记录调用 fn(k, line), k 为记录的全局序号
+        template<typename F>
+        void parse_records(std::string_view text, const RecordIndex &index, char comment, F &&fn) {
+            ThreadPool::instance().parallel_for(0, index.bounds.size() - 1, 1, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t c = lo; c < hi; ++c) {
+                    std::size_t k = index.first[c];
+                    for_each_line(text, index.bounds[c], index.bounds[c + 1], [&](std::string_view line) {
+                        if (is_record(line, comment))
+                            fn(k++, line);
+                    });
+                }
+            });
+        }
+
+        // 跳过空白后解析一个数 (允许前导 '+'), 失败时返回 nullptr
+        template<typename T>
+        const char *parse_number(const char *p, const char *end, T &value, char delimiter = 0) {
+            while (p < end && is_blank(*p) && *p != delimiter)
+                ++p;
+            if (p < end && *p == '+')
+                ++p;
+            auto [ptr, ec] = std::from_chars(p, end, value);
+            return ec == std::errc{} ? ptr : nullptr;
+        }
+
+        inline std::string record_error(const char *what, std::size_t k) {
+            return std::string(what) + " (record " + std::to_string(k + 1) + ").";
+        }
+
+        // Matrix Market 文件头
+        enum class MarketField { Real,
+                                 Integer,
+                                 Complex,
+                                 Pattern };
+        enum class MarketSymmetry { General,
+                                    Symmetric,
+                                    SkewSymmetric,
+                                    Hermitian };
+
+        struct MarketHeader {
+            bool coordinate{};
+            MarketField field{};
+            MarketSymmetry symmetry{};
+            std::size_t rows{}, cols{}, entries{};
+            std::string_view body;// 尺寸行之后的内容
+        };
+
+        inline std::string lower(std::string_view s) {
+            std::string res(s);
+            for (char &c: res)
+                c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            return res;
+        }
+
+        inline MarketHeader parse_market_header(std::string_view text) {
+            auto next_line = [&](std::string_view &line) {
+                if (text.empty())
+                    return false;
+                std::size_t nl = text.find('\n');
+                line = text.substr(0, nl);
+                text = nl == std::string_view::npos ? std::string_view{} : text.substr(nl + 1);
+                if (!line.empty() && line.back() == '\r')
+                    line.remove_suffix(1);
+                return true;
+            };
+
+            std::string_view line;
+            if (!next_line(line) || !line.starts_with("%%MatrixMarket"))
+                throw std::invalid_argument("Missing Matrix Market banner.");
+
+            std::vector<std::string> tokens;
+            for (std::size_t i = 0; i < line.size();) {
+                while (i < line.size() && is_blank(line[i]))
+                    ++i;
+                std::size_t j = i;
+                while (j < line.size() && !is_blank(line[j]))
+                    ++j;
+                if (j > i)
+                    tokens.push_back(lower(line.substr(i, j - i)));
+                i = j;
+            }
+            if (tokens.size() != 5 || tokens[1] != "matrix")
+                throw std::invalid_argument("Unsupported Matrix Market banner.");
+
+            MarketHeader header;
+            if (tokens[2] == "coordinate")
+                header.coordinate = true;
+            else if (tokens[2] != "array")
+                throw std::invalid_argument("Unsupported Matrix Market format.");
+
+            if (tokens[3] == "real" || tokens[3] == "double")
+                header.field = MarketField::Real;
+            else if (tokens[3] == "integer")
+                header.field = MarketField::Integer;
+            else if (tokens[3] == "complex")
+                header.field = MarketField::Complex;
+            else if (tokens[3] == "pattern" && header.coordinate)
+                header.field = MarketField::Pattern;
+            else
+                throw std::invalid_argument("Unsupported Matrix Market field.");
+
+            if (tokens[4] == "general")
+                header.symmetry = MarketSymmetry::General;
+            else if (tokens[4] == "symmetric")
+                header.symmetry = MarketSymmetry::Symmetric;
+            else if (tokens[4] == "skew-symmetric")
+                header.symmetry = MarketSymmetry::SkewSymmetric;
+            else if (tokens[4] == "hermitian" && header.field == MarketField::Complex)
+                header.symmetry = MarketSymmetry::Hermitian;
+            else
+                throw std::invalid_argument("Unsupported Matrix Market symmetry.");
+
+            do {
+                if (!next_line(line))
+                    throw std::invalid_argument("Missing Matrix Market size line.");
+            } while (!is_record(line, '%'));
+
+            const char *p = line.data(), *end = line.data() + line.size();
+            p = parse_number(p, end, header.rows);
+            if (p)
+                p = parse_number(p, end, header.cols);
+            if (p && header.coordinate)
+                p = parse_number(p, end, header.entries);
+            if (!p)
+                throw std::invalid_argument("Malformed Matrix Market size line.");
+
+            if (header.symmetry != MarketSymmetry::General && header.rows != header.cols)
+                throw std::invalid_argument("Symmetric Matrix Market matrix must be square.");
+            if (!header.coordinate) {
+                std::size_t n = header.rows;
+                header.entries = header.symmetry == MarketSymmetry::General         ? header.rows * header.cols
+                                 : header.symmetry == MarketSymmetry::SkewSymmetric ? n * (n - (n > 0)) / 2
+                                                                                    : n * (n + 1) / 2;
+            }
+            header.body = text;
+            return header;
+        }
+
+        // 读取一行中最后的值; pattern 文件的值为 1. 值之后只能有空白, 否则返回空指针
+        template<typename T>
+        const char *parse_market_value(const char *p, const char *end, MarketField field, T &value) {
+            if (field == MarketField::Pattern) {
+                value = T(1);
+            } else if constexpr (is_complex_v<T>) {
+                typename T::value_type re{}, im{};
+                p = parse_number(p, end, re);
+                if (p && field == MarketField::Complex)
+                    p = parse_number(p, end, im);
+                value = T(re, im);
+            } else {
+                p = parse_number(p, end, value);
+            }
+            while (p && p < end && is_blank(*p))
+                ++p;
+            return p == end ? p : nullptr;
+        }
+
+        // 对称存储时由 (i, j) 的值得到 (j, i) 的值
+        template<typename T>
+        T mirror_value(const T &value, MarketSymmetry symmetry) {
+            if (symmetry == MarketSymmetry::SkewSymmetric)
+                return -value;
+            if (symmetry == MarketSymmetry::Hermitian)
+                return conj_value(value);
+            return value;
+        }
+
+        // 数组格式中第 k 个值的位置: 一般矩阵按列存储全部元素,
+        // 对称矩阵只按列存储下三角 (斜对称时不含对角线)
+        inline std::pair<std::size_t, std::size_t> array_position(const MarketHeader &header, std::size_t k) {
+            if (header.symmetry == MarketSymmetry::General)
+                return {k % header.rows, k / header.rows};
+
+            // 第 j 列有 m - j 个值, 之前共 j * (2m - j + 1) / 2 个
+            std::size_t skip = header.symmetry == MarketSymmetry::SkewSymmetric;
+            std::size_t m = header.rows - skip;
+            auto offset = [m](std::size_t j) { return j * (2 * m - j + 1) / 2; };
+            double b = 2.0 * static_cast<double>(m) + 1;
+            auto j = static_cast<std::size_t>(std::max(0.0, (b - std::sqrt(b * b - 8.0 * static_cast<double>(k))) / 2));
+            while (j > 0 && offset(j) > k)
+                --j;
+            while (offset(j + 1) <= k)
+                ++j;
+            return {j + skip + (k - offset(j)), j};
+        }
+
+        template<typename T>
+        struct MarketEntry {
+            std::size_t row, col;
+            T value;
+        };
+
+        // 并行解析坐标格式的全部元素 (下标已转为从 0 开始)
+        template<typename T>
+        std::vector<MarketEntry<T>> parse_market_entries(const MarketHeader &header) {
+            RecordIndex index = index_records(header.body, '%');
+            if (index.total() != header.entries)
+                throw std::invalid_argument("Matrix Market entry count does not match the size line.");
+
+            std::vector<MarketEntry<T>> entries(header.entries);
+            parse_records(header.body, index, '%', [&](std::size_t k, std::string_view line) {
+                const char *p = line.data(), *end = line.data() + line.size();
+                auto &e = entries[k];
+                p = parse_number(p, end, e.row);
+                if (p)
+                    p = parse_number(p, end, e.col);
+                if (p)
+                    p = parse_market_value(p, end, header.field, e.value);
+                if (!p)
+                    throw std::invalid_argument(record_error("Malformed Matrix Market entry", k));
+                if (e.row == 0 || e.col == 0 || e.row > header.rows || e.col > header.cols)
+                    throw std::out_of_range(record_error("Matrix Market index out of range", k));
+                --e.row;
+                --e.col;
+            });
+            return entries;
+        }
+
+        template<typename T>
+        struct market_scalar {
+            using type = T;
+        };
+
+        template<typename T>
+        struct market_scalar<std::complex<T>> {
+            using type = T;
+        };
+
+        template<typename T>
+        void check_market_field(const MarketHeader &header) {
+            if (header.field == MarketField::Complex && !is_complex_v<T>)
+                throw std::invalid_argument("Cannot load a complex Matrix Market file into a real matrix.");
+            // from_chars 读整数时会在小数点处停下, 截断而不报错
+            if (header.field != MarketField::Integer && header.field != MarketField::Pattern &&
+                std::is_integral_v<typename market_scalar<T>::type>)
+                throw std::invalid_argument("Cannot load a real Matrix Market file into an integer matrix.");
+        }
+
+    }// namespace detail
+
+    // 解析 CSV 文本: 每个非空行为一行, 列数由第一行决定, 各行列数必须相同.
+    // 文本按行边界切块, 先并行统计每块行数, 再并行地用 std::from_chars 直接写入结果矩阵.
+    template<typename T = double, Layout L = Layout::RowMajor>
+    Matrix<T, L> parse_csv(std::string_view text, char delimiter = ',') {
+        detail::RecordIndex index = detail::index_records(text, 0);
+        if (index.total() == 0)
+            return {};
+
+        // 列数取第一条记录的分隔符数加一
+        std::string_view first = text;
+        for (;;) {
+            std::size_t nl = first.find('\n');
+            if (detail::is_record(first.substr(0, nl), 0)) {
+                first = first.substr(0, nl);
+                break;
+            }
+            first.remove_prefix(nl + 1);
+        }
+        std::size_t cols = 1 + static_cast<std::size_t>(std::count(first.begin(), first.end(), delimiter));
+
+        Matrix<T, L> res(index.total(), cols);
+        auto view = res.view();
+        detail::parse_records(text, index, 0, [&](std::size_t k, std::string_view line) {
+            const char *p = line.data(), *end = line.data() + line.size();
+            for (std::size_t j = 0; j < cols; ++j) {
+                if (j > 0) {
+                    if (p == end || *p != delimiter)
+                        throw std::invalid_argument(detail::record_error("CSV row has the wrong number of columns", k));
+                    ++p;
+                }
+                p = detail::parse_number(p, end, view(k, j), delimiter);
+                if (!p)
+                    throw std::invalid_argument(detail::record_error("Malformed CSV value", k));
+                while (p < end && detail::is_blank(*p) && *p != delimiter)
+                    ++p;
+            }
+            if (p != end)
+                throw std::invalid_argument(detail::record_error("CSV row has the wrong number of columns", k));
+        });
+        return res;
+    }
+
+    // 映射文件后解析, 见 parse_csv
+    template<typename T = double, Layout L = Layout::RowMajor>
+    Matrix<T, L> load_csv(const std::string &path, char delimiter = ',') {
+        detail::MappedFile file(path);
+        return parse_csv<T, L>(file.text(), delimiter);
+    }
+
+    // 解析 Matrix Market 文本为稠密矩阵, 支持 coordinate / array 两种格式以及对称存储.
+    // array 格式按列存储, 读入列主序矩阵时写入是连续的.
+    template<typename T = double, Layout L = Layout::RowMajor>
+    Matrix<T, L> parse_matrix_market(std::string_view text) {
+        auto header = detail::parse_market_header(text);
+        detail::check_market_field<T>(header);
+        Matrix<T, L> res(header.rows, header.cols);
+        auto view = res.view();
+        bool mirrored = header.symmetry != detail::MarketSymmetry::General;
+
+        if (header.coordinate) {
+            for (const auto &e: detail::parse_market_entries<T>(header)) {
+                view(e.row, e.col) += e.value;
+                if (mirrored && e.row != e.col)
+                    view(e.col, e.row) += detail::mirror_value(e.value, header.symmetry);
+            }
+            return res;
+        }
+
+        detail::RecordIndex index = detail::index_records(header.body, '%');
+        if (index.total() != header.entries)
+            throw std::invalid_argument("Matrix Market entry count does not match the size line.");
+        detail::parse_records(header.body, index, '%', [&](std::size_t k, std::string_view line) {
+            auto [i, j] = detail::array_position(header, k);
+            const char *end = line.data() + line.size();
+            const char *p = detail::parse_market_value(line.data(), end, header.field, view(i, j));
+            if (!p)
+                throw std::invalid_argument(detail::record_error("Malformed Matrix Market entry", k));
+            if (mirrored)
+                view(j, i) = detail::mirror_value(view(i, j), header.symmetry);
+        });
+        return res;
+    }
+
+    // 解析 coordinate 格式的 Matrix Market 文本为 CSR 稀疏矩阵, 对称存储的元素会展开到两侧.
+    template<typename T = double>
+    CsrMatrix<T> parse_matrix_market_sparse(std::string_view text) {
+        auto header = detail::parse_market_header(text);
+        detail::check_market_field<T>(header);
+        if (!header.coordinate)
+            throw std::invalid_argument("Matrix Market array files are dense; use parse_matrix_market.");
+
+        auto entries = detail::parse_market_entries<T>(header);
+        bool mirrored = header.symmetry != detail::MarketSymmetry::General;
+
+        std::vector<std::size_t> row_ptr(header.rows + 1, 0);
+        for (const auto &e: entries) {
+            ++row_ptr[e.row + 1];
+            if (mirrored && e.row != e.col)
+                ++row_ptr[e.col + 1];
+        }
+        for (std::size_t i = 0; i < header.rows; ++i)
+            row_ptr[i + 1] += row_ptr[i];
+
+        std::size_t nnz = row_ptr.back();
+        std::vector<std::size_t> col_index(nnz), cursor(row_ptr.begin(), row_ptr.end() - 1);
+        std::vector<T> values(nnz);
+        for (const auto &e: entries) {
+            std::size_t p = cursor[e.row]++;
+            col_index[p] = e.col;
+            values[p] = e.value;
+            if (mirrored && e.row != e.col) {
+                p = cursor[e.col]++;
+                col_index[p] = e.row;
+                values[p] = detail::mirror_value(e.value, header.symmetry);
+            }
+        }
+
+        // 每行按列号排序; 稳定排序使重复坐标保持文件中的次序
+        ThreadPool::instance().parallel_for(0, header.rows, detail::kSparseRowGrain, [&](std::size_t lo, std::size_t hi) {
+            std::vector<std::pair<std::size_t, T>> row;
+            for (std::size_t i = lo; i < hi; ++i) {
+                std::size_t b = row_ptr[i], e = row_ptr[i + 1];
+                if (std::is_sorted(col_index.begin() + static_cast<std::ptrdiff_t>(b), col_index.begin() + static_cast<std::ptrdiff_t>(e)))
+                    continue;
+                row.clear();
+                for (std::size_t p = b; p < e; ++p)
+                    row.emplace_back(col_index[p], values[p]);
+                std::stable_sort(row.begin(), row.end(), [](const auto &x, const auto &y) { return x.first < y.first; });
+                for (std::size_t p = b; p < e; ++p)
+                    std::tie(col_index[p], values[p]) = row[p - b];
+            }
+        });
+
+        return {header.rows, header.cols, std::move(row_ptr), std::move(col_index), std::move(values)};
+    }
+
+    template<typename T = double, Layout L = Layout::RowMajor>
+    Matrix<T, L> load_matrix_market(const std::string &path) {
+        detail::MappedFile file(path);
+        return parse_matrix_market<T, L>(file.text());
+    }
+
+    template<typename T = double>
+    CsrMatrix<T> load_matrix_market_sparse(const std::string &path) {
+        detail::MappedFile file(path);
+        return parse_matrix_market_sparse<T>(file.text());
+    }
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_IO
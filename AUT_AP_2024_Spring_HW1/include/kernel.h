@@ -0,0 +1,319 @@
+#ifndef AUT_AP_2024_Spring_HW1_KERNEL
+#define AUT_AP_2024_Spring_HW1_KERNEL
+
+#include <algorithm>
+#include <complex>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "instrument.h"
+#include "matrix.h"
+#include "thread_pool.h"
+#include "tuning.h"
+
+namespace algebra {
+
+    namespace detail {
+
+        // C = beta * C, beta 为 0 时直接清零 (不读取 C 中可能存在的 NaN)
+        template<typename T, Layout L>
+        void scale(MatrixView<T, L> C, T beta) {
+            if (beta == T{1})
+                return;
+
+            std::size_t lines = L == Layout::RowMajor ? C.rows() : C.cols();
+            std::size_t len = L == Layout::RowMajor ? C.cols() : C.rows();
+
+            for (std::size_t l = 0; l < lines; ++l) {
+                T *line = C.data() + l * C.ld();
+                if (beta == T{0})
+                    std::fill_n(line, len, T{0});
+                else
+                    for (std::size_t x = 0; x < len; ++x)
+                        line[x] *= beta;
+            }
+        }
+
+        // 小矩阵: 根据三个操作数的存储顺序选择最内层连续的循环次序
+        template<typename T, Layout LA, Layout LB, Layout LC>
+        void gemm_small(T alpha, MatrixView<const T, LA> A, MatrixView<const T, LB> B,
+                        T beta, MatrixView<T, LC> C) {
+            std::size_t m = C.rows(), n = C.cols(), k = A.cols();
+
+            if constexpr (LA == Layout::RowMajor && LB == Layout::ColMajor) {
+                // A 的行与 B 的列都连续: 内积形式 (i-j-k)
+                for (std::size_t i = 0; i < m; ++i) {
+                    for (std::size_t j = 0; j < n; ++j) {
+                        T sum{};
+                        for (std::size_t p = 0; p < k; ++p)
+                            sum += A(i, p) * B(p, j);
+                        C(i, j) = beta == T{0} ? alpha * sum : alpha * sum + beta * C(i, j);
+                    }
+                }
+            } else if constexpr (LA == Layout::ColMajor && LC == Layout::ColMajor) {
+                // A 与 C 的列连续: 按列做 axpy (j-k-i)
+                scale(C, beta);
+                for (std::size_t j = 0; j < n; ++j) {
+                    for (std::size_t p = 0; p < k; ++p) {
+                        T b = alpha * B(p, j);
+                        for (std::size_t i = 0; i < m; ++i)
+                            C(i, j) += A(i, p) * b;
+                    }
+                }
+            } else {
+                // 其余情况按行做 axpy (i-k-j), B 与 C 行主序时最内层连续
+                scale(C, beta);
+                for (std::size_t i = 0; i < m; ++i) {
+                    for (std::size_t p = 0; p < k; ++p) {
+                        T a = alpha * A(i, p);
+                        for (std::size_t j = 0; j < n; ++j)
+                            C(i, j) += a * B(p, j);
+                    }
+                }
+            }
+        }
+
+        // 将 src 的 rows x cols 子块打包为行主序连续缓冲区 (元素转换为累加类型 P), 按源存储顺序读取
+        template<typename T, Layout L, typename P>
+        void pack(MatrixView<const T, L> src, std::size_t row, std::size_t col,
+                  std::size_t rows, std::size_t cols, P *dst) {
+            if constexpr (L == Layout::RowMajor) {
+                for (std::size_t i = 0; i < rows; ++i)
+                    std::copy_n(&src(row + i, col), cols, dst + i * cols);
+            } else {
+                for (std::size_t j = 0; j < cols; ++j) {
+                    const T *line = &src(row, col + j);
+                    for (std::size_t i = 0; i < rows; ++i)
+                        dst[i * cols + j] = line[i];
+                }
+            }
+        }
+
+        // 将行主序的累加块写回 C: C = alpha * tile + beta * C, 在累加类型 P 中计算后按 C 的存储顺序写入
+        template<typename P, typename T, Layout L>
+        void unpack(const P *tile, T alpha, T beta, MatrixView<T, L> C,
+                    std::size_t row, std::size_t col, std::size_t rows, std::size_t cols) {
+            auto update = [&](std::size_t i, std::size_t j) {
+                T &c = C(row + i, col + j);
+                P v = static_cast<P>(alpha) * tile[i * cols + j];
+                c = static_cast<T>(beta == T{0} ? v : v + static_cast<P>(beta) * static_cast<P>(c));
+            };
+
+            if constexpr (L == Layout::RowMajor) {
+                for (std::size_t i = 0; i < rows; ++i)
+                    for (std::size_t j = 0; j < cols; ++j)
+                        update(i, j);
+            } else {
+                for (std::size_t j = 0; j < cols; ++j)
+                    for (std::size_t i = 0; i < rows; ++i)
+                        update(i, j);
+            }
+        }
+
+        // 打包后的微内核: tile(mb x nb) += a(mb x kb) * b(kb x nb), 三者均为行主序连续.
+        // 每次同时更新 R 行, 读入的 b 行被复用 R 次; 每个元素的累加次序与 R 无关
+        template<std::size_t R, typename T>
+        void gemm_micro_rows(const T *a, const T *b, T *tile,
+                             std::size_t mb, std::size_t kb, std::size_t nb) {
+            std::size_t i = 0;
+            for (; i + R <= mb; i += R) {
+                for (std::size_t p = 0; p < kb; ++p) {
+                    T a_ip[R];
+                    for (std::size_t r = 0; r < R; ++r)
+                        a_ip[r] = a[(i + r) * kb + p];
+                    const T *b_row = b + p * nb;
+                    for (std::size_t j = 0; j < nb; ++j) {
+                        T b_pj = b_row[j];
+                        for (std::size_t r = 0; r < R; ++r)
+                            tile[(i + r) * nb + j] += a_ip[r] * b_pj;
+                    }
+                }
+            }
+            if constexpr (R > 1)
+                gemm_micro_rows<1>(a + i * kb, b, tile + i * nb, mb - i, kb, nb);
+        }
+
+        template<typename T>
+        void gemm_micro(const T *a, const T *b, T *tile,
+                        std::size_t mb, std::size_t kb, std::size_t nb) {
+            switch (tuning().gemm_unroll) {
+                case 4:
+                    gemm_micro_rows<4>(a, b, tile, mb, kb, nb);
+                    break;
+                case 2:
+                    gemm_micro_rows<2>(a, b, tile, mb, kb, nb);
+                    break;
+                default:
+                    gemm_micro_rows<1>(a, b, tile, mb, kb, nb);
+            }
+        }
+
+        // 计算 C 的一个 mb x nb 输出块: 所有 k 块在累加类型 Acc 的块中累加完毕后只写回 C 一次;
+        // 打包缓冲区按线程复用
+        template<typename Acc, typename T, Layout LA, Layout LB, Layout LC>
+        void gemm_tile(T alpha, MatrixView<const T, LA> A, MatrixView<const T, LB> B, T beta, MatrixView<T, LC> C,
+                       std::size_t ic, std::size_t jc, std::size_t mb, std::size_t nb) {
+            std::size_t block_k = tuning().gemm_block_k;
+            thread_local std::vector<Acc> a_pack, b_pack, tile;
+            a_pack.resize(mb * block_k);
+            b_pack.resize(block_k * nb);
+            tile.resize(mb * nb);
+            std::fill_n(tile.begin(), mb * nb, Acc{0});
+
+            std::size_t k = A.cols();
+            for (std::size_t pc = 0; pc < k; pc += block_k) {
+                std::size_t kb = std::min(block_k, k - pc);
+                pack(B, pc, jc, kb, nb, b_pack.data());
+                pack(A, ic, pc, mb, kb, a_pack.data());
+                gemm_micro(a_pack.data(), b_pack.data(), tile.data(), mb, kb, nb);
+            }
+
+            unpack(tile.data(), alpha, beta, C, ic, jc, mb, nb);
+        }
+
+        // 通用矩阵乘法内核: C = alpha * A * B + beta * C, 支持任意存储顺序组合, 乘积在 Acc 中累加.
+        // 大矩阵按 C 的输出块在线程池上并行, 每个输出块只由一个任务写入, 结果与线程数无关.
+        // parallel 为 false 时在调用线程内完成 (调用方已在外层并行, 如批量乘法)
+        template<typename Acc, typename T, Layout LA, Layout LB, Layout LC>
+        void gemm_kernel_acc(T alpha, MatrixView<const T, LA> A, MatrixView<const T, LB> B,
+                             T beta, MatrixView<T, LC> C, bool parallel = true) {
+            std::size_t m = C.rows(), n = C.cols(), k = A.cols();
+
+            if (m == 0 || n == 0)
+                return;
+
+            if (k == 0 || alpha == T{0}) {
+                scale(C, beta);
+                return;
+            }
+
+            // 小矩阵的直接循环在 T 中累加, 只用于 Acc 与 T 相同的情况
+            const TuningConfig &config = tuning();
+            if (std::is_same_v<Acc, T> && m * n * k <= config.small_gemm) {
+                gemm_small(alpha, A, B, beta, C);
+                return;
+            }
+
+            // 打包后所有存储顺序组合都走同一个连续的微内核
+            std::size_t block_m = config.gemm_block_m, block_n = config.gemm_block_n;
+            std::size_t tiles_m = (m + block_m - 1) / block_m;
+            std::size_t tiles_n = (n + block_n - 1) / block_n;
+            std::size_t tiles = tiles_m * tiles_n;
+            auto run = [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t t = lo; t < hi; ++t) {
+                    std::size_t ic = t / tiles_n * block_m, jc = t % tiles_n * block_n;
+                    gemm_tile<Acc>(alpha, A, B, beta, C, ic, jc, std::min(block_m, m - ic), std::min(block_n, n - jc));
+                }
+            };
+
+            // 串行时不访问线程池, 也就不会在 fork 出的工作进程 (shm.h) 中创建线程池
+            if (!parallel || m * n * k < config.parallel_gemm)
+                run(0, tiles);
+            else
+                ThreadPool::instance().parallel_for(0, tiles, 1, run);
+        }
+
+        // 把复数视图拆分为实部与虚部两个连续平面, 保持存储顺序
+        template<typename R, Layout L>
+        void split_planes(MatrixView<const std::complex<R>, L> src, Matrix<R, L> &re, Matrix<R, L> &im) {
+            std::size_t lines = L == Layout::RowMajor ? src.rows() : src.cols();
+            std::size_t len = L == Layout::RowMajor ? src.cols() : src.rows();
+            re = Matrix<R, L>(src.rows(), src.cols());
+            im = Matrix<R, L>(src.rows(), src.cols());
+            R *r = re.data(), *i = im.data();
+
+            for (std::size_t l = 0; l < lines; ++l) {
+                const std::complex<R> *x = src.data() + l * src.ld();
+                for (std::size_t p = 0; p < len; ++p) {
+                    r[l * len + p] = x[p].real();
+                    i[l * len + p] = x[p].imag();
+                }
+            }
+        }
+
+        // 复数矩阵乘法 (分平面的 4M 算法): Cr = Ar Br - Ai Bi, Ci = Ar Bi + Ai Br.
+        // 四次实数 GEMM 都走打包的实数微内核 (可向量化), 避免逐元素的复数乘法; 小矩阵直接计算
+        template<typename R, Layout LA, Layout LB, Layout LC>
+        void gemm_complex(std::complex<R> alpha, MatrixView<const std::complex<R>, LA> A,
+                          MatrixView<const std::complex<R>, LB> B, std::complex<R> beta,
+                          MatrixView<std::complex<R>, LC> C) {
+            using T = std::complex<R>;
+            std::size_t m = C.rows(), n = C.cols(), k = A.cols();
+
+            if (m * n * k <= tuning().small_gemm || alpha == T{0}) {
+                gemm_kernel_acc<T>(alpha, A, B, beta, C);
+                return;
+            }
+
+            Matrix<R, LA> ar, ai;
+            Matrix<R, LB> br, bi;
+            split_planes(A, ar, ai);
+            split_planes(B, br, bi);
+
+            Matrix<R, LC> cr(m, n), ci(m, n);
+            gemm_kernel_acc<R>(R{1}, std::as_const(ar).view(), std::as_const(br).view(), R{0}, cr.view());
+            gemm_kernel_acc<R>(R{-1}, std::as_const(ai).view(), std::as_const(bi).view(), R{1}, cr.view());
+            gemm_kernel_acc<R>(R{1}, std::as_const(ar).view(), std::as_const(bi).view(), R{0}, ci.view());
+            gemm_kernel_acc<R>(R{1}, std::as_const(ai).view(), std::as_const(br).view(), R{1}, ci.view());
+
+            // 合并两个平面: C = alpha * (Cr + i Ci) + beta * C
+            std::size_t lines = LC == Layout::RowMajor ? m : n;
+            std::size_t len = LC == Layout::RowMajor ? n : m;
+            const R *r = std::as_const(cr).data(), *im = std::as_const(ci).data();
+            for (std::size_t l = 0; l < lines; ++l) {
+                T *c = C.data() + l * C.ld();
+                for (std::size_t p = 0; p < len; ++p) {
+                    T v = alpha * T(r[l * len + p], im[l * len + p]);
+                    c[p] = beta == T{0} ? v : v + beta * c[p];
+                }
+            }
+        }
+
+        // 单线程调用时复数不拆分平面, 以免每次调用分配临时矩阵
+        template<typename T, Layout LA, Layout LB, Layout LC>
+        void gemm_kernel(T alpha, MatrixView<const T, LA> A, MatrixView<const T, LB> B,
+                         T beta, MatrixView<T, LC> C, bool parallel = true) {
+            if constexpr (is_complex_v<T>) {
+                if (parallel) {
+                    gemm_complex(alpha, A, B, beta, C);
+                    return;
+                }
+            }
+            gemm_kernel_acc<T>(alpha, A, B, beta, C, parallel);
+        }
+
+    }// namespace detail
+
+    // 矩阵乘法, 操作数可为任意存储顺序, 结果存储顺序由 LC 指定 (默认行主序)
+    template<Layout LC = Layout::RowMajor, typename TA, Layout LA, typename TB, Layout LB,
+             typename T = std::remove_const_t<TA>>
+        requires std::is_same_v<T, std::remove_const_t<TB>>
+    Matrix<T, LC> multiply(MatrixView<TA, LA> matrixA, MatrixView<TB, LB> matrixB) {
+        if (matrixA.empty() || matrixB.empty())
+            throw std::invalid_argument("Matrices must not be empty.");
+
+        if (matrixA.cols() != matrixB.rows())
+            throw std::invalid_argument("Matrix dimension mismatch.");
+
+        ALGEBRA_TRACE("multiply", matrixA.rows(), matrixB.cols(), matrixA.cols(),
+                      2.0 * matrixA.rows() * matrixA.cols() * matrixB.cols(),
+                      (1.0 * matrixA.rows() * matrixA.cols() + 1.0 * matrixB.rows() * matrixB.cols() +
+                       1.0 * matrixA.rows() * matrixB.cols()) * sizeof(T));
+
+        Matrix<T, LC> res(matrixA.rows(), matrixB.cols());
+        detail::gemm_kernel(T{1}, MatrixView<const T, LA>(matrixA), MatrixView<const T, LB>(matrixB),
+                            T{0}, res.view());
+
+        return res;
+    }
+
+    template<Layout LC = Layout::RowMajor, typename T, Layout LA, Layout LB>
+    Matrix<T, LC> multiply(const Matrix<T, LA> &matrixA, const Matrix<T, LB> &matrixB) {
+        return multiply<LC>(matrixA.view(), matrixB.view());
+    }
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_KERNEL
@@ -0,0 +1,241 @@
+#ifndef AUT_AP_2024_Spring_HW1_LU
+#define AUT_AP_2024_Spring_HW1_LU
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "instrument.h"
+#include "kernel.h"
+#include "matrix.h"
+#include "thread_pool.h"
+
+namespace algebra {
+
+    namespace detail {
+
+        // 消去时尾部子矩阵元素数达到该值才并行更新各行
+        constexpr std::size_t kParallelElimination = 128 * 128;
+    }
+
+    // 行列式的符号与绝对值的对数: det = sign * exp(log_abs), 奇异时 sign = 0, log_abs = -inf
+    template<typename T>
+    struct LogDeterminant {
+        int sign;
+        T log_abs;
+    };
+
+    // 部分选主元的 LU 分解: P * A = L * U, L 为单位下三角, 与 U 一起保存在同一个行主序矩阵中.
+    // 右视分块算法: 面板内逐列消去, 再解出 U12, 尾部矩阵的更新 A22 -= L21 * U12 交给 GEMM 内核.
+    template<typename T>
+    class LU {
+    public:
+        template<MatrixLike M>
+        explicit LU(const M &matrix)
+            : lu{relayout_view(const_view(matrix))}, perm(lu.rows()) {
+            if (lu.empty())
+                throw std::invalid_argument("Matrices must not be empty.");
+            if (lu.rows() != lu.cols())
+                throw std::invalid_argument("Matrix must be square.");
+
+            ALGEBRA_TRACE("LU", size(), size(), size(), 2.0 / 3.0 * size() * size() * size(), 2.0 * lu.size() * sizeof(T));
+            std::iota(perm.begin(), perm.end(), std::size_t{0});
+            factorize();
+        }
+
+        std::size_t size() const { return lu.rows(); }
+
+        // 是否存在为零的主元
+        bool singular() const { return is_singular; }
+
+        // 合并保存的 L (严格下三角部分) 与 U (上三角部分)
+        const Matrix<T> &factors() const { return lu; }
+
+        // 第 i 行来自原矩阵的第 perm[i] 行
+        const std::vector<std::size_t> &pivots() const { return perm; }
+
+        T determinant() const {
+            if (is_singular)
+                return T{0};
+            T det = static_cast<T>(sign);
+            for (std::size_t i = 0; i < size(); ++i)
+                det *= lu(i, i);
+            return det;
+        }
+
+        // 在对数域中累加 |u_ii|, 不会上溢或下溢
+        LogDeterminant<T> slogdet() const
+            requires(!detail::is_complex_v<T>)
+        {
+            if (is_singular)
+                return {0, -std::numeric_limits<T>::infinity()};
+            int res_sign = sign;
+            T log_abs{};
+            for (std::size_t i = 0; i < size(); ++i) {
+                log_abs += std::log(std::abs(lu(i, i)));
+                if (lu(i, i) < T{0})
+                    res_sign = -res_sign;
+            }
+            return {res_sign, log_abs};
+        }
+
+        // 求解 A * X = B
+        template<Layout L>
+        Matrix<T, L> solve(const Matrix<T, L> &rhs) const {
+            if (rhs.rows() != size())
+                throw std::invalid_argument("Matrix dimension mismatch.");
+            check_singular();
+            ALGEBRA_TRACE("LU::solve", size(), rhs.cols(), size(), 2.0 * size() * size() * rhs.cols(),
+                          (1.0 * size() * size() + 2.0 * size() * rhs.cols()) * sizeof(T));
+
+            // 以行主序计算, 使前代/回代的内层循环沿右端项的行连续
+            std::size_t n = size(), m = rhs.cols();
+            Matrix<T> x(n, m);
+            for (std::size_t i = 0; i < n; ++i)
+                for (std::size_t j = 0; j < m; ++j)
+                    x(i, j) = rhs(perm[i], j);
+
+            T *data = x.data();
+            for (std::size_t i = 0; i < n; ++i) {
+                T *row = data + i * m;
+                for (std::size_t k = 0; k < i; ++k) {
+                    T l = lu(i, k);
+                    const T *src = data + k * m;
+                    for (std::size_t j = 0; j < m; ++j)
+                        row[j] -= l * src[j];
+                }
+            }
+            for (std::size_t i = n; i-- > 0;) {
+                T *row = data + i * m;
+                for (std::size_t k = i + 1; k < n; ++k) {
+                    T u = lu(i, k);
+                    const T *src = data + k * m;
+                    for (std::size_t j = 0; j < m; ++j)
+                        row[j] -= u * src[j];
+                }
+                T d = lu(i, i);
+                for (std::size_t j = 0; j < m; ++j)
+                    row[j] /= d;
+            }
+
+            return relayout<L>(x);
+        }
+
+        std::vector<T> solve(const std::vector<T> &rhs) const {
+            Matrix<T> b(rhs.size(), 1);
+            std::copy(rhs.begin(), rhs.end(), b.data());
+            Matrix<T> x = solve(b);
+            return {x.data(), x.data() + x.size()};
+        }
+
+        Matrix<T> inverse() const {
+            Matrix<T> identity(size(), size());
+            for (std::size_t i = 0; i < size(); ++i)
+                identity(i, i) = T{1};
+            return solve(identity);
+        }
+
+    private:
+        template<Layout L>
+        static Matrix<T> relayout_view(MatrixView<const T, L> view) {
+            Matrix<T> res(view.rows(), view.cols());
+            detail::copy_blocked(view, res.view());
+            return res;
+        }
+
+        void check_singular() const {
+            if (is_singular)
+                throw std::invalid_argument("Singular matrix.");
+        }
+
+        void factorize() {
+            std::size_t n = size();
+            T *a = lu.data();
+
+            std::size_t panel = tuning().lu_panel;
+            for (std::size_t k0 = 0; k0 < n; k0 += panel) {
+                std::size_t kb = std::min(panel, n - k0);
+                std::size_t k1 = k0 + kb;
+                factor_panel(k0, k1);
+
+                if (k1 == n)
+                    break;
+
+                // U12 = L11^{-1} * A12 (L11 为单位下三角), 逐行做前代
+                std::size_t rest = n - k1;
+                for (std::size_t i = k0 + 1; i < k1; ++i) {
+                    T *row = a + i * n + k1;
+                    for (std::size_t p = k0; p < i; ++p) {
+                        T l = a[i * n + p];
+                        const T *src = a + p * n + k1;
+                        for (std::size_t j = 0; j < rest; ++j)
+                            row[j] -= l * src[j];
+                    }
+                }
+
+                // A22 -= L21 * U12
+                MatrixView<const T> l21{a + k1 * n + k0, rest, kb, n};
+                MatrixView<const T> u12{a + k0 * n + k1, kb, rest, n};
+                detail::gemm_kernel(T{-1}, l21, u12, T{1}, MatrixView<T>{a + k1 * n + k1, rest, rest, n});
+            }
+        }
+
+        // 对 [k0, k1) 列组成的面板做非分块消去, 行交换作用于整行
+        void factor_panel(std::size_t k0, std::size_t k1) {
+            std::size_t n = size();
+            T *a = lu.data();
+
+            for (std::size_t k = k0; k < k1; ++k) {
+                std::size_t p = k;
+                for (std::size_t i = k + 1; i < n; ++i)
+                    if (std::abs(a[i * n + k]) > std::abs(a[p * n + k]))
+                        p = i;
+
+                if (a[p * n + k] == T{0}) {
+                    is_singular = true;
+                    continue;
+                }
+
+                if (p != k) {
+                    std::swap_ranges(a + k * n, a + (k + 1) * n, a + p * n);
+                    std::swap(perm[k], perm[p]);
+                    sign = -sign;
+                }
+
+                // 面板内的秩 1 更新, 每一行互相独立
+                const T *pivot_row = a + k * n;
+                T pivot = pivot_row[k];
+                auto eliminate = [&](std::size_t lo, std::size_t hi) {
+                    for (std::size_t i = lo; i < hi; ++i) {
+                        T *row = a + i * n;
+                        T l = row[k] /= pivot;
+                        for (std::size_t j = k + 1; j < k1; ++j)
+                            row[j] -= l * pivot_row[j];
+                    }
+                };
+
+                std::size_t work = (n - k - 1) * (k1 - k);
+                if (work < detail::kParallelElimination)
+                    eliminate(k + 1, n);
+                else
+                    ThreadPool::instance().parallel_for(k + 1, n, std::max<std::size_t>(1, detail::kParallelElimination / (k1 - k)), eliminate);
+            }
+        }
+
+        Matrix<T> lu;
+        std::vector<std::size_t> perm;
+        int sign{1};
+        bool is_singular{false};
+    };
+
+    template<MatrixLike M>
+    LU(const M &) -> LU<typename decltype(const_view(std::declval<M>()))::value_type>;
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_LU
@@ -0,0 +1,347 @@
+#ifndef AUT_AP_2024_Spring_HW1_MATRIX
+#define AUT_AP_2024_Spring_HW1_MATRIX
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "algebra.h"
+#include "instrument.h"
+#include "tuning.h"
+
+namespace algebra {
+
+    // 连续存储矩阵的存储顺序
+    enum class Layout { RowMajor,
+                        ColMajor };
+
+    // 转置后的存储顺序
+    constexpr Layout flip(Layout layout) {
+        return layout == Layout::RowMajor ? Layout::ColMajor : Layout::RowMajor;
+    }
+
+    // 非拥有的矩阵视图, ld 为主维度步长 (行主序为行间距, 列主序为列间距)
+    template<typename T, Layout L = Layout::RowMajor>
+    class MatrixView {
+    public:
+        using value_type = std::remove_const_t<T>;
+        static constexpr Layout layout = L;
+
+        MatrixView() = default;
+
+        MatrixView(T *data, std::size_t rows, std::size_t cols)
+            : MatrixView(data, rows, cols, L == Layout::RowMajor ? cols : rows) {}
+
+        MatrixView(T *data, std::size_t rows, std::size_t cols, std::size_t ld)
+            : data_{data}, rows_{rows}, cols_{cols}, ld_{ld} {}
+
+        // 可写视图可以隐式转换为只读视图
+        operator MatrixView<const T, L>() const
+            requires(!std::is_const_v<T>)
+        {
+            return {data_, rows_, cols_, ld_};
+        }
+
+        T &operator()(std::size_t i, std::size_t j) const {
+            if constexpr (L == Layout::RowMajor)
+                return data_[i * ld_ + j];
+            else
+                return data_[j * ld_ + i];
+        }
+
+        // 从 (row, col) 开始的 rows x cols 子块, 与原视图共享数据
+        MatrixView block(std::size_t row, std::size_t col, std::size_t rows, std::size_t cols) const {
+            return {&(*this)(row, col), rows, cols, ld_};
+        }
+
+        T *data() const { return data_; }
+        std::size_t rows() const { return rows_; }
+        std::size_t cols() const { return cols_; }
+        std::size_t ld() const { return ld_; }
+        bool empty() const { return rows_ == 0 || cols_ == 0; }
+
+        // 数据是否按存储顺序紧密排列 (可以当作一维数组处理)
+        bool contiguous() const {
+            return ld_ == (L == Layout::RowMajor ? cols_ : rows_);
+        }
+
+    private:
+        T *data_{};
+        std::size_t rows_{}, cols_{}, ld_{};
+    };
+
+    // 连续存储的矩阵, 存储顺序由模板参数决定
+    // 存储采用写时复制: 复制矩阵只增加缓冲区引用计数, 第一次通过非 const 接口访问时才克隆数据.
+    // 引用计数是原子的, 共享同一缓冲区的副本可以分别交给不同线程.
+    // 注意: 可写视图 (view(), data()) 在之后复制矩阵时不会被克隆, 不要在复制后继续通过旧视图写入.
+    template<typename T, Layout L = Layout::RowMajor>
+    class Matrix {
+    public:
+        using value_type = T;
+        static constexpr Layout layout = L;
+
+        Matrix() = default;
+
+        Matrix(std::size_t rows, std::size_t cols, T value = T{})
+            : rows_{rows}, cols_{cols}, data_{allocate(rows * cols)} {
+            std::fill_n(data_.get(), size(), value);
+        }
+
+        // 按行给出元素, 与存储顺序无关
+        Matrix(std::initializer_list<std::initializer_list<T>> rows)
+            : Matrix(rows.size(), rows.size() ? rows.begin()->size() : 0) {
+            std::size_t i = 0;
+            for (const auto &row: rows) {
+                if (row.size() != cols_)
+                    throw std::invalid_argument("Matrix rows must have equal length.");
+                std::size_t j = 0;
+                for (const auto &elem: row)
+                    data_[index(i, j++)] = elem;
+                ++i;
+            }
+        }
+
+        // 从嵌套向量 MATRIX<T> 转换
+        explicit Matrix(const MATRIX<T> &nested)
+            : Matrix(nested.size(), nested.empty() ? 0 : nested[0].size()) {
+            for (std::size_t i = 0; i < rows_; ++i) {
+                if (nested[i].size() != cols_)
+                    throw std::invalid_argument("Matrix rows must have equal length.");
+                for (std::size_t j = 0; j < cols_; ++j)
+                    data_[index(i, j)] = nested[i][j];
+            }
+        }
+
+        // 非 const 访问会先确保独占缓冲区; 只读时请通过 const 引用访问以避免检查开销
+        T &operator()(std::size_t i, std::size_t j) {
+            detach();
+            return data_[index(i, j)];
+        }
+
+        const T &operator()(std::size_t i, std::size_t j) const {
+            return data_[index(i, j)];
+        }
+
+        MatrixView<T, L> view() { return {data(), rows_, cols_}; }
+        MatrixView<const T, L> view() const { return {data(), rows_, cols_}; }
+
+        T *data() {
+            detach();
+            return data_.get();
+        }
+        const T *data() const { return data_.get(); }
+        std::size_t rows() const { return rows_; }
+        std::size_t cols() const { return cols_; }
+        std::size_t size() const { return rows_ * cols_; }
+        bool empty() const { return rows_ == 0 || cols_ == 0; }
+
+        // 是否独占缓冲区 (写入时无需克隆)
+        bool unique() const { return !data_ || data_.use_count() == 1; }
+
+        // 与另一矩阵 (可为不同存储顺序) 是否共享同一缓冲区
+        template<Layout M>
+        bool shares_storage_with(const Matrix<T, M> &other) const {
+            return data_ && data_ == other.data_;
+        }
+
+        // 转换为嵌套向量 MATRIX<T>
+        MATRIX<T> to_nested() const {
+            MATRIX<T> res(rows_, std::vector<T>(cols_));
+            for (std::size_t i = 0; i < rows_; ++i)
+                for (std::size_t j = 0; j < cols_; ++j)
+                    res[i][j] = (*this)(i, j);
+            return res;
+        }
+
+        bool operator==(const Matrix &other) const {
+            return rows_ == other.rows_ && cols_ == other.cols_ &&
+                   (data_ == other.data_ || std::equal(data_.get(), data_.get() + size(), other.data_.get()));
+        }
+
+    private:
+        template<typename, Layout>
+        friend class Matrix;
+
+        template<typename U, Layout M>
+        friend Matrix<U, flip(M)> transpose(Matrix<U, M> matrix);
+
+        static std::shared_ptr<T[]> allocate(std::size_t size) {
+            return size ? std::make_shared_for_overwrite<T[]>(size) : nullptr;
+        }
+
+        // 写时复制: 缓冲区被共享时克隆一份独占副本
+        void detach() {
+            if (unique()) {
+                // 与其他副本释放引用时的写入同步
+                std::atomic_thread_fence(std::memory_order_acquire);
+                return;
+            }
+            auto copy = allocate(size());
+            std::copy_n(data_.get(), size(), copy.get());
+            data_ = std::move(copy);
+        }
+
+        std::size_t index(std::size_t i, std::size_t j) const {
+            if constexpr (L == Layout::RowMajor)
+                return i * cols_ + j;
+            else
+                return j * rows_ + i;
+        }
+
+        std::size_t rows_{}, cols_{};
+        std::shared_ptr<T[]> data_;
+    };
+
+    // 统一取只读视图, 使算法可以同时接受 Matrix 与 MatrixView
+    template<typename T, Layout L>
+    MatrixView<const T, L> const_view(const Matrix<T, L> &matrix) {
+        return matrix.view();
+    }
+
+    template<typename T, Layout L>
+    MatrixView<const T, L> const_view(MatrixView<T, L> view) {
+        return view;
+    }
+
+    // 可以取得只读视图的矩阵类型
+    template<typename M>
+    concept MatrixLike = requires(const M &m) { const_view(m); };
+
+    // O(1) 转置: 交换行列并翻转存储顺序, 不移动任何元素
+    template<typename T, Layout L>
+    MatrixView<T, flip(L)> transpose(MatrixView<T, L> view) {
+        return {view.data(), view.cols(), view.rows(), view.ld()};
+    }
+
+    // O(1) 转置: 结果与原矩阵共享缓冲区, 只翻转存储顺序, 写入时才复制
+    template<typename T, Layout L>
+    Matrix<T, flip(L)> transpose(Matrix<T, L> matrix) {
+        Matrix<T, flip(L)> res;
+        res.rows_ = matrix.cols_;
+        res.cols_ = matrix.rows_;
+        res.data_ = std::move(matrix.data_);
+        return res;
+    }
+
+    namespace detail {
+
+        template<typename T, Layout LS, Layout LD>
+        void copy_blocked(MatrixView<const T, LS> src, MatrixView<T, LD> dst) {
+            std::size_t rows = src.rows(), cols = src.cols();
+
+            if constexpr (LS == LD) {
+                // 存储顺序相同, 逐条主维度线复制
+                std::size_t lines = LS == Layout::RowMajor ? rows : cols;
+                std::size_t len = LS == Layout::RowMajor ? cols : rows;
+                for (std::size_t l = 0; l < lines; ++l)
+                    std::copy_n(src.data() + l * src.ld(), len, dst.data() + l * dst.ld());
+            } else {
+                // 分块大小使源块和目标块同时留在 L1 缓存中
+                std::size_t block = tuning().transpose_block;
+                for (std::size_t ib = 0; ib < rows; ib += block) {
+                    std::size_t ie = std::min(ib + block, rows);
+                    for (std::size_t jb = 0; jb < cols; jb += block) {
+                        std::size_t je = std::min(jb + block, cols);
+                        for (std::size_t i = ib; i < ie; ++i)
+                            for (std::size_t j = jb; j < je; ++j)
+                                dst(i, j) = src(i, j);
+                    }
+                }
+            }
+        }
+
+    }// namespace detail
+
+    // 改变存储顺序 (物理重排), 元素的逻辑位置不变
+    template<Layout To, typename T, Layout From>
+    Matrix<T, To> relayout(const Matrix<T, From> &matrix) {
+        if constexpr (To == From) {
+            return matrix;
+        } else {
+            ALGEBRA_TRACE("relayout", matrix.rows(), matrix.cols(), 1, 0, 2.0 * matrix.size() * sizeof(T));
+            Matrix<T, To> res(matrix.rows(), matrix.cols());
+            detail::copy_blocked(matrix.view(), res.view());
+            return res;
+        }
+    }
+
+    namespace detail {
+
+        // 逐元素运算: 结果接管 matrixA 的缓冲区 (右值且独占时原地计算, 否则写时复制)
+        template<typename T, Layout LA, Layout LB, typename Op>
+        Matrix<T, LA> elementwise(Matrix<T, LA> matrixA, const Matrix<T, LB> &matrixB, Op op) {
+            if (matrixA.rows() != matrixB.rows() || matrixA.cols() != matrixB.cols())
+                throw std::invalid_argument("Matrix dimension mismatch.");
+
+            MatrixView<T, LA> res = matrixA.view();
+            MatrixView<const T, LB> other = matrixB.view();
+
+            if constexpr (LA == LB) {
+                T *out = res.data();
+                const T *in = other.data();
+                for (std::size_t x = 0; x < matrixA.size(); ++x)
+                    out[x] = op(out[x], in[x]);
+            } else {
+                std::size_t lines = LA == Layout::RowMajor ? res.rows() : res.cols();
+                std::size_t len = LA == Layout::RowMajor ? res.cols() : res.rows();
+                for (std::size_t l = 0; l < lines; ++l)
+                    for (std::size_t x = 0; x < len; ++x) {
+                        std::size_t i = LA == Layout::RowMajor ? l : x;
+                        std::size_t j = LA == Layout::RowMajor ? x : l;
+                        res(i, j) = op(res(i, j), other(i, j));
+                    }
+            }
+
+            return matrixA;
+        }
+
+    }// namespace detail
+
+    template<typename T, Layout LA, Layout LB>
+    Matrix<T, LA> sum_sub(Matrix<T, LA> matrixA, const Matrix<T, LB> &matrixB,
+                          std::optional<std::string> operation = "sum") {
+        if (matrixA.rows() != matrixB.rows() || matrixA.cols() != matrixB.cols())
+            throw std::invalid_argument("Matrix dimension mismatch.");
+        ALGEBRA_TRACE("sum_sub", matrixA.rows(), matrixA.cols(), 1, matrixA.size(), 3.0 * matrixA.size() * sizeof(T));
+        if (operation.value() == "sub")
+            return detail::elementwise(std::move(matrixA), matrixB, [](T a, T b) { return a - b; });
+        return detail::elementwise(std::move(matrixA), matrixB, [](T a, T b) { return a + b; });
+    }
+
+    template<typename T, Layout LA, Layout LB>
+    Matrix<T, LA> hadamard_product(Matrix<T, LA> matrixA, const Matrix<T, LB> &matrixB) {
+        if (matrixA.rows() != matrixB.rows() || matrixA.cols() != matrixB.cols())
+            throw std::invalid_argument("Matrix dimension mismatch.");
+        ALGEBRA_TRACE("hadamard_product", matrixA.rows(), matrixA.cols(), 1, matrixA.size(), 3.0 * matrixA.size() * sizeof(T));
+        return detail::elementwise(std::move(matrixA), matrixB, [](T a, T b) { return a * b; });
+    }
+
+    template<typename T, Layout L>
+    Matrix<T, L> multiply(Matrix<T, L> matrix, const T scalar) {
+        ALGEBRA_TRACE("multiply (scalar)", matrix.rows(), matrix.cols(), 1, matrix.size(), 2.0 * matrix.size() * sizeof(T));
+        T *data = matrix.data();
+        for (std::size_t x = 0; x < matrix.size(); ++x)
+            data[x] *= scalar;
+        return matrix;
+    }
+
+    // 与 MATRIX 版本输出格式相同, 直接按视图读取元素
+    template<MatrixLike M>
+    void display(const M &matrix, FormatOptions options = {}, std::ostream &out = std::cout) {
+        auto view = const_view(matrix);
+        MatrixFormatter(options).write(out, view.rows(), view.cols(),
+                                       [&](std::size_t i, std::size_t j) -> const auto & { return view(i, j); });
+        out.flush();
+    }
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_MATRIX
@@ -0,0 +1,212 @@
+#ifndef AUT_AP_2024_Spring_HW1_POWER
+#define AUT_AP_2024_Spring_HW1_POWER
+
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "algebra.h"
+#include "kernel.h"
+#include "lu.h"
+#include "matrix.h"
+#include "reduction.h"
+
+namespace algebra {
+
+    namespace detail {
+
+        template<typename T, Layout L>
+        void check_square(const Matrix<T, L> &matrix) {
+            if (matrix.empty())
+                throw std::invalid_argument("Matrices must not be empty.");
+            if (matrix.rows() != matrix.cols())
+                throw std::invalid_argument("Matrix must be square.");
+        }
+
+        template<typename T, Layout L>
+        Matrix<T, L> identity(std::size_t n) {
+            Matrix<T, L> res(n, n);
+            for (std::size_t i = 0; i < n; ++i)
+                res(i, i) = T{1};
+            return res;
+        }
+
+        // out = a * b, out 为预先分配好的独占缓冲区
+        template<typename T, Layout L>
+        void multiply_into(const Matrix<T, L> &a, const Matrix<T, L> &b, Matrix<T, L> &out) {
+            gemm_kernel(T{1}, a.view(), b.view(), T{0}, out.view());
+        }
+
+    }// namespace detail
+
+    // 矩阵幂 A^k: 二进制快速幂, 只使用三个缓冲区轮换 (结果, 底数, 临时), 共 O(log k) 次乘法
+    template<typename T, Layout L>
+    Matrix<T, L> matrix_power(const Matrix<T, L> &matrix, unsigned long long k) {
+        detail::check_square(matrix);
+        std::size_t n = matrix.rows();
+
+        if (k == 0)
+            return detail::identity<T, L>(n);
+
+        // 底数使用独立的缓冲区, 之后轮换时不会触发写时复制
+        Matrix<T, L> base(n, n), scratch(n, n), result;
+        std::copy_n(matrix.data(), matrix.size(), base.data());
+
+        for (;;) {
+            if (k & 1) {
+                if (result.empty()) {
+                    result = Matrix<T, L>(n, n);
+                    std::copy_n(std::as_const(base).data(), base.size(), result.data());
+                } else {
+                    detail::multiply_into(result, base, scratch);
+                    std::swap(result, scratch);
+                }
+            }
+
+            k >>= 1;
+            if (k == 0)
+                break;
+
+            detail::multiply_into(base, base, scratch);
+            std::swap(base, scratch);
+        }
+
+        return result;
+    }
+
+    template<typename T>
+    MATRIX<T> matrix_power(const MATRIX<T> &matrix, unsigned long long k) {
+        return matrix_power(Matrix<T>(matrix), k).to_nested();
+    }
+
+    namespace detail {
+
+        // Higham (2005) 缩放平方法中各阶 Padé 近似可直接使用的 1-范数上界
+        constexpr std::array<double, 5> kPadeTheta = {1.495585217958292e-2, 2.539398330063230e-1,
+                                                      9.504178996162932e-1, 2.097847961257068e0,
+                                                      5.371920351148152e0};
+
+        constexpr std::array<double, 14> kPade13 = {64764752532480000., 32382376266240000., 7771770303897600.,
+                                                    1187353796428800., 129060195264000., 10559470521600.,
+                                                    670442572800., 33522128640., 1323241920., 40840800.,
+                                                    960960., 16380., 182., 1.};
+
+        template<std::size_t N>
+        constexpr std::array<double, N> pade_coefficients() {
+            if constexpr (N == 4)
+                return {120., 60., 12., 1.};
+            else if constexpr (N == 6)
+                return {30240., 15120., 3360., 420., 30., 1.};
+            else if constexpr (N == 8)
+                return {17297280., 8648640., 1995840., 277200., 25200., 1512., 56., 1.};
+            else
+                return {17643225600., 8821612800., 2075673600., 302702400., 30270240.,
+                        2162160., 110880., 3960., 90., 1.};
+        }
+
+        // out = sum c_i * terms_i (+ c_I * I)
+        template<typename T, Layout L>
+        Matrix<T, L> combine(std::initializer_list<std::pair<double, const Matrix<T, L> *>> terms, double identity_coef) {
+            std::size_t n = terms.begin()->second->rows();
+            Matrix<T, L> res(n, n);
+            T *out = res.data();
+            for (auto [coef, term]: terms) {
+                const T *in = term->data();
+                for (std::size_t x = 0; x < res.size(); ++x)
+                    out[x] += static_cast<T>(coef) * in[x];
+            }
+            for (std::size_t i = 0; i < n; ++i)
+                res(i, i) += static_cast<T>(identity_coef);
+            return res;
+        }
+
+        // 低阶 (m = 3, 5, 7, 9) Padé 近似的 U (奇数项) 与 V (偶数项)
+        template<std::size_t N, typename T, Layout L>
+        std::pair<Matrix<T, L>, Matrix<T, L>> pade_low(const Matrix<T, L> &A) {
+            constexpr auto b = pade_coefficients<N>();
+            std::size_t n = A.rows();
+
+            // powers[j] = A^(2j)
+            std::vector<Matrix<T, L>> powers;
+            powers.push_back(identity<T, L>(n));
+            powers.push_back(multiply<L>(A, A));
+            for (std::size_t j = 2; 2 * j < N; ++j)
+                powers.push_back(multiply<L>(powers[j - 1], powers[1]));
+
+            Matrix<T, L> odd(n, n), V(n, n);
+            for (std::size_t j = 0; 2 * j < N; ++j) {
+                const T *p = std::as_const(powers[j]).data();
+                T *o = odd.data(), *v = V.data();
+                for (std::size_t x = 0; x < odd.size(); ++x) {
+                    o[x] += static_cast<T>(b[2 * j + 1]) * p[x];
+                    v[x] += static_cast<T>(b[2 * j]) * p[x];
+                }
+            }
+
+            return {multiply<L>(A, odd), std::move(V)};
+        }
+
+        template<typename T, Layout L>
+        std::pair<Matrix<T, L>, Matrix<T, L>> pade13(const Matrix<T, L> &A) {
+            const auto &b = kPade13;
+            Matrix<T, L> A2 = multiply<L>(A, A), A4 = multiply<L>(A2, A2), A6 = multiply<L>(A4, A2);
+
+            Matrix<T, L> u_high = combine<T, L>({{b[13], &A6}, {b[11], &A4}, {b[9], &A2}}, 0);
+            Matrix<T, L> u_inner = combine<T, L>({{b[7], &A6}, {b[5], &A4}, {b[3], &A2}}, b[1]);
+            gemm_kernel(T{1}, std::as_const(A6).view(), std::as_const(u_high).view(), T{1}, u_inner.view());
+            Matrix<T, L> U = multiply<L>(A, u_inner);
+
+            Matrix<T, L> v_high = combine<T, L>({{b[12], &A6}, {b[10], &A4}, {b[8], &A2}}, 0);
+            Matrix<T, L> V = combine<T, L>({{b[6], &A6}, {b[4], &A4}, {b[2], &A2}}, b[0]);
+            gemm_kernel(T{1}, std::as_const(A6).view(), std::as_const(v_high).view(), T{1}, V.view());
+
+            return {std::move(U), std::move(V)};
+        }
+
+    }// namespace detail
+
+    // 矩阵指数 e^A: 缩放平方法 + [m/m] Padé 近似 (Higham 2005), 根据 1-范数选择阶数
+    template<std::floating_point T, Layout L>
+    Matrix<T, L> expm(const Matrix<T, L> &matrix) {
+        detail::check_square(matrix);
+
+        double norm1 = static_cast<double>(norm(matrix, Norm::L1));
+        unsigned squarings = 0;
+        std::pair<Matrix<T, L>, Matrix<T, L>> uv;
+
+        if (norm1 <= detail::kPadeTheta[0])
+            uv = detail::pade_low<4>(matrix);
+        else if (norm1 <= detail::kPadeTheta[1])
+            uv = detail::pade_low<6>(matrix);
+        else if (norm1 <= detail::kPadeTheta[2])
+            uv = detail::pade_low<8>(matrix);
+        else if (norm1 <= detail::kPadeTheta[3])
+            uv = detail::pade_low<10>(matrix);
+        else {
+            if (norm1 > detail::kPadeTheta[4])
+                squarings = static_cast<unsigned>(std::ceil(std::log2(norm1 / detail::kPadeTheta[4])));
+            uv = detail::pade13(multiply(matrix, std::ldexp(T{1}, -static_cast<int>(squarings))));
+        }
+
+        auto &[U, V] = uv;
+        // (V - U) * X = V + U
+        Matrix<T, L> X = LU<T>(sum_sub(V, U, "sub")).solve(sum_sub(V, U));
+
+        // 平方 s 次, 两个缓冲区轮换
+        Matrix<T, L> scratch(X.rows(), X.cols());
+        for (unsigned s = 0; s < squarings; ++s) {
+            detail::multiply_into(X, X, scratch);
+            std::swap(X, scratch);
+        }
+
+        return X;
+    }
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_POWER
@@ -0,0 +1,175 @@
+#ifndef AUT_AP_2024_Spring_HW1_PRECISION
+#define AUT_AP_2024_Spring_HW1_PRECISION
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "kernel.h"
+#include "lu.h"
+#include "matrix.h"
+#include "reduction.h"
+
+namespace algebra {
+
+    // 精度策略
+    enum class Precision {
+        Single,// float 存储, float 计算
+        Mixed, // float 存储, double 累加; 求解时以 float 分解, 再迭代精化到 double 精度
+        Double // 全部使用 double
+    };
+
+    namespace detail {
+
+        // 按元素转换类型, 保持存储顺序
+        template<typename To, typename From, Layout L>
+        Matrix<To, L> convert(const Matrix<From, L> &matrix) {
+            Matrix<To, L> res(matrix.rows(), matrix.cols());
+            const From *src = matrix.data();
+            To *dst = res.data();
+            for (std::size_t x = 0; x < matrix.size(); ++x)
+                dst[x] = static_cast<To>(src[x]);
+            return res;
+        }
+
+        // 迭代精化的最大步数, 超过后改用 double 分解
+        constexpr std::size_t kRefinementSteps = 10;
+
+    }// namespace detail
+
+    // float 矩阵乘法: Single 在 float 中累加; Mixed 在打包块中以 double 累加, 每个结果只舍入一次;
+    // Double 先转换为 double 矩阵再相乘, 带宽翻倍, 作为精度基准
+    template<Layout LC = Layout::RowMajor, Layout LA, Layout LB>
+    Matrix<float, LC> multiply(const Matrix<float, LA> &matrixA, const Matrix<float, LB> &matrixB, Precision precision) {
+        if (matrixA.empty() || matrixB.empty())
+            throw std::invalid_argument("Matrices must not be empty.");
+        if (matrixA.cols() != matrixB.rows())
+            throw std::invalid_argument("Matrix dimension mismatch.");
+
+        Matrix<float, LC> res(matrixA.rows(), matrixB.cols());
+        switch (precision) {
+            case Precision::Single:
+                detail::gemm_kernel(1.f, matrixA.view(), matrixB.view(), 0.f, res.view());
+                break;
+            case Precision::Mixed:
+                detail::gemm_kernel_acc<double>(1.f, matrixA.view(), matrixB.view(), 0.f, res.view());
+                break;
+            case Precision::Double:
+                res = detail::convert<float>(multiply<LC>(detail::convert<double>(matrixA), detail::convert<double>(matrixB)));
+                break;
+        }
+        return res;
+    }
+
+    // 按精度策略求解 double 线性方程组.
+    // Mixed: 以 float 做 LU 分解 (带宽与计算量减半), 残差 r = b - A x 用 double 计算, 修正量用 float 因子求解,
+    // 直到 ||r|| <= sqrt(n) * eps * ||A|| * ||x|| (LAPACK dsgesv 的判据); 若迭代不收敛 (条件数过大) 则改用 double 分解.
+    class PrecisionSolver {
+    public:
+        template<Layout L>
+        PrecisionSolver(const Matrix<double, L> &matrix, Precision precision)
+            : a{relayout<Layout::RowMajor>(matrix)}, policy{precision} {
+            a_norm = norm(a, Norm::Inf);
+            if (policy == Precision::Double) {
+                lu_double.emplace(a);
+            } else {
+                lu_single.emplace(detail::convert<float>(a));
+                if (lu_single->singular()) {
+                    if (policy == Precision::Single)
+                        throw std::invalid_argument("Singular matrix.");
+                    // float 中奇异但 double 中可能可解
+                    lu_double.emplace(a);
+                }
+            }
+        }
+
+        Precision precision() const { return policy; }
+
+        // 最近一次 solve 的精化步数 (已满足判据时为 0)
+        std::size_t iterations() const { return steps; }
+
+        // 最近一次 solve 是否因精化不收敛而改用了 double 分解
+        bool fell_back() const { return fallback; }
+
+        template<Layout L>
+        Matrix<double, L> solve(const Matrix<double, L> &rhs) {
+            if (rhs.rows() != a.rows())
+                throw std::invalid_argument("Matrix dimension mismatch.");
+
+            steps = 0;
+            fallback = false;
+            if (lu_double && (policy == Precision::Double || lu_single->singular()))
+                return lu_double->solve(rhs);
+
+            Matrix<double> b = relayout<Layout::RowMajor>(rhs);
+            Matrix<double> x = detail::convert<double>(lu_single->solve(detail::convert<float>(b)));
+            if (policy == Precision::Single)
+                return relayout<L>(x);
+
+            const double tolerance = std::sqrt(static_cast<double>(a.rows())) * std::numeric_limits<double>::epsilon() * a_norm;
+            Matrix<double> r(b.rows(), b.cols());
+            for (;; ++steps) {
+                // r = b - A x
+                std::copy_n(b.data(), b.size(), r.data());
+                detail::gemm_kernel(-1.0, std::as_const(a).view(), std::as_const(x).view(), 1.0, r.view());
+
+                if (norm(r, Norm::Max) <= tolerance * norm(x, Norm::Max))
+                    return relayout<L>(x);
+                if (steps == detail::kRefinementSteps)
+                    break;
+
+                Matrix<double> d = detail::convert<double>(lu_single->solve(detail::convert<float>(r)));
+                double *xd = x.data();
+                const double *dd = std::as_const(d).data();
+                for (std::size_t i = 0; i < x.size(); ++i)
+                    xd[i] += dd[i];
+            }
+
+            fallback = true;
+            if (!lu_double)
+                lu_double.emplace(a);
+            return lu_double->solve(rhs);
+        }
+
+        std::vector<double> solve(const std::vector<double> &rhs) {
+            Matrix<double> b(rhs.size(), 1);
+            std::copy(rhs.begin(), rhs.end(), b.data());
+            Matrix<double> x = solve(b);
+            return {x.data(), x.data() + x.size()};
+        }
+
+        Matrix<double> inverse() {
+            Matrix<double> identity(a.rows(), a.rows());
+            for (std::size_t i = 0; i < a.rows(); ++i)
+                identity(i, i) = 1.0;
+            return solve(identity);
+        }
+
+    private:
+        Matrix<double> a;
+        double a_norm;
+        Precision policy;
+        std::optional<LU<float>> lu_single;
+        std::optional<LU<double>> lu_double;
+        std::size_t steps{};
+        bool fallback{};
+    };
+
+    template<Layout L>
+    Matrix<double, L> solve(const Matrix<double, L> &matrix, const Matrix<double, L> &rhs, Precision precision) {
+        return PrecisionSolver(matrix, precision).solve(rhs);
+    }
+
+    template<Layout L>
+    Matrix<double> inverse(const Matrix<double, L> &matrix, Precision precision) {
+        return PrecisionSolver(matrix, precision).inverse();
+    }
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_PRECISION
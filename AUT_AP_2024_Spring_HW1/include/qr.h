@@ -0,0 +1,290 @@
+#ifndef AUT_AP_2024_Spring_HW1_QR
+#define AUT_AP_2024_Spring_HW1_QR
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "instrument.h"
+#include "kernel.h"
+#include "matrix.h"
+#include "reduction.h"
+#include "thread_pool.h"
+
+namespace algebra {
+
+    namespace detail {
+
+        // 分块 Householder 的面板宽度
+        constexpr std::size_t kQRPanel = 32;
+
+        // 面板内单列更新的并行阈值 (需要更新的元素数)
+        constexpr std::size_t kParallelPanel = std::size_t{1} << 15;
+
+    }// namespace detail
+
+    // 分块 Householder QR 分解: A = Q * R (A 为 m x n, m >= n).
+    // 每个面板的反射子以紧凑 WY 形式 H_1 ... H_k = I - V * T * V^T 保存,
+    // 尾部矩阵与右端项的更新都归结为两次 GEMM 和一次小三角矩阵乘法.
+    template<typename T>
+    class QR {
+    public:
+        using ColMatrix = Matrix<T, Layout::ColMajor>;
+
+        template<MatrixLike M>
+        explicit QR(const M &matrix) {
+            auto view = const_view(matrix);
+            if (view.empty())
+                throw std::invalid_argument("Matrices must not be empty.");
+            if (view.rows() < view.cols())
+                throw std::invalid_argument("QR requires rows >= columns.");
+
+            ALGEBRA_TRACE("QR", view.rows(), view.cols(), view.cols(),
+                          (2.0 * view.rows() - 2.0 / 3.0 * view.cols()) * view.cols() * view.cols(),
+                          2.0 * view.rows() * view.cols() * sizeof(T));
+            a = ColMatrix(view.rows(), view.cols());
+            detail::copy_blocked(view, a.view());
+            factorize();
+        }
+
+        std::size_t rows() const { return a.rows(); }
+        std::size_t cols() const { return a.cols(); }
+
+        // n x n 上三角因子 R
+        ColMatrix r() const {
+            std::size_t n = cols();
+            ColMatrix res(n, n);
+            for (std::size_t j = 0; j < n; ++j)
+                for (std::size_t i = 0; i <= j; ++i)
+                    res(i, j) = a(i, j);
+            return res;
+        }
+
+        // m x n 的精简 Q 因子 (列正交)
+        ColMatrix q() const {
+            ColMatrix res(rows(), cols());
+            for (std::size_t j = 0; j < cols(); ++j)
+                res(j, j) = T{1};
+            apply_q(res.view());
+            return res;
+        }
+
+        // 最小二乘解: 使 ||A * X - B|| 最小
+        template<Layout L>
+        Matrix<T, L> solve(const Matrix<T, L> &rhs) const {
+            if (rhs.rows() != rows())
+                throw std::invalid_argument("Matrix dimension mismatch.");
+
+            std::size_t n = cols(), k = rhs.cols();
+            // |R_ii| 不超过 eps * max(m, n) * max |R_ii| 时视为秩亏
+            T max_diag{};
+            for (std::size_t i = 0; i < n; ++i)
+                max_diag = std::max(max_diag, std::abs(a(i, i)));
+            T tol = std::numeric_limits<T>::epsilon() * std::max(rows(), n) * max_diag;
+            for (std::size_t i = 0; i < n; ++i)
+                if (!(std::abs(a(i, i)) > tol))
+                    throw std::invalid_argument("Rank-deficient matrix.");
+
+            ColMatrix b(rows(), k);
+            detail::copy_blocked(rhs.view(), b.view());
+            apply_qt(b.view());
+
+            // 回代求解 R * X = (Q^T * B) 的前 n 行
+            Matrix<T, L> x(n, k);
+            for (std::size_t c = 0; c < k; ++c) {
+                T *col = b.data() + c * rows();
+                for (std::size_t i = n; i-- > 0;) {
+                    col[i] /= a(i, i);
+                    const T *r_col = a.data() + i * rows();
+                    for (std::size_t p = 0; p < i; ++p)
+                        col[p] -= r_col[p] * col[i];
+                }
+                for (std::size_t i = 0; i < n; ++i)
+                    x(i, c) = col[i];
+            }
+            return x;
+        }
+
+        std::vector<T> solve(const std::vector<T> &rhs) const {
+            ColMatrix b(rhs.size(), 1);
+            std::copy(rhs.begin(), rhs.end(), b.data());
+            ColMatrix x = solve(b);
+            return {x.data(), x.data() + x.size()};
+        }
+
+        // B = Q^T * B, B 为 m x k
+        void apply_qt(MatrixView<T, Layout::ColMajor> B) const {
+            for (std::size_t p = 0; p < panels.size(); ++p)
+                apply_panel(p, B, true);
+        }
+
+        // B = Q * B, B 为 m x k
+        void apply_q(MatrixView<T, Layout::ColMajor> B) const {
+            for (std::size_t p = panels.size(); p-- > 0;)
+                apply_panel(p, B, false);
+        }
+
+    private:
+        struct Panel {
+            std::size_t offset;// 面板第一列的下标
+            ColMatrix v;       // (m - offset) x jb, 单位下三角
+            ColMatrix t;       // jb x jb, 上三角
+        };
+
+        // 对以 x[0] 开头、长度为 len 的列生成反射子, 返回 tau, x[1:] 被替换为 v 的尾部
+        static T householder(T *x, std::size_t len) {
+            T tail = detail::sum_lanes<T>(1, len, [x](std::size_t i) { return x[i] * x[i]; });
+            if (tail == T{0})
+                return T{0};
+
+            T alpha = x[0];
+            T beta = -std::copysign(std::sqrt(alpha * alpha + tail), alpha);
+            T scale = T{1} / (alpha - beta);
+            for (std::size_t i = 1; i < len; ++i)
+                x[i] *= scale;
+            x[0] = beta;
+            return (beta - alpha) / beta;
+        }
+
+        void factorize() {
+            std::size_t m = rows(), n = cols();
+            T *data = a.data();
+
+            for (std::size_t j0 = 0; j0 < n; j0 += detail::kQRPanel) {
+                std::size_t jb = std::min(detail::kQRPanel, n - j0);
+                std::size_t len = m - j0;
+                std::vector<T> tau(jb);
+
+                // 面板分解: 逐列生成反射子, 并作用到面板内其余各列 (各列互相独立, 可并行)
+                for (std::size_t j = 0; j < jb; ++j) {
+                    T *x = data + (j0 + j) * m + j0 + j;
+                    std::size_t xlen = len - j;
+                    tau[j] = householder(x, xlen);
+                    if (tau[j] == T{0})
+                        continue;
+
+                    auto update = [&](std::size_t lo, std::size_t hi) {
+                        for (std::size_t c = lo; c < hi; ++c) {
+                            T *y = data + (j0 + c) * m + j0 + j;
+                            T w = y[0] + detail::sum_lanes<T>(1, xlen, [x, y](std::size_t i) { return x[i] * y[i]; });
+                            w *= tau[j];
+                            y[0] -= w;
+                            for (std::size_t i = 1; i < xlen; ++i)
+                                y[i] -= w * x[i];
+                        }
+                    };
+
+                    std::size_t grain = std::max<std::size_t>(1, detail::kParallelPanel / xlen);
+                    ThreadPool::instance().parallel_for(j + 1, jb, grain, update);
+                }
+
+                Panel panel{j0, ColMatrix(len, jb), ColMatrix(jb, jb)};
+                build_panel(panel, tau);
+
+                // 尾部更新: A2 = (I - V T V^T)^T A2
+                if (j0 + jb < n) {
+                    auto trailing = a.view().block(j0, j0 + jb, len, n - j0 - jb);
+                    apply_block(panel, trailing, true);
+                }
+
+                panels.push_back(std::move(panel));
+            }
+        }
+
+        // 取出显式的 V, 并按 LAPACK dlarft (前向, 按列) 构造 T
+        void build_panel(Panel &panel, const std::vector<T> &tau) {
+            std::size_t m = rows(), len = panel.v.rows(), jb = panel.v.cols();
+            const T *src = std::as_const(a).data();
+            T *v = panel.v.data();
+
+            for (std::size_t j = 0; j < jb; ++j) {
+                T *col = v + j * len;
+                col[j] = T{1};
+                std::copy(src + (panel.offset + j) * m + panel.offset + j + 1,
+                          src + (panel.offset + j + 1) * m, col + j + 1);
+            }
+
+            T *t = panel.t.data();
+            for (std::size_t i = 0; i < jb; ++i) {
+                // T(0:i, i) = -tau_i * T(0:i, 0:i) * V(:, 0:i)^T * v_i
+                std::vector<T> w(i);
+                const T *vi = v + i * len;
+                for (std::size_t p = 0; p < i; ++p) {
+                    const T *vp = v + p * len;
+                    w[p] = detail::sum_lanes<T>(i, len, [vp, vi](std::size_t r) { return vp[r] * vi[r]; });
+                }
+                for (std::size_t r = 0; r < i; ++r) {
+                    T s{};
+                    for (std::size_t p = r; p < i; ++p)
+                        s += t[p * jb + r] * w[p];
+                    t[i * jb + r] = -tau[i] * s;
+                }
+                t[i * jb + i] = tau[i];
+            }
+        }
+
+        void apply_panel(std::size_t p, MatrixView<T, Layout::ColMajor> B, bool transposed) const {
+            const Panel &panel = panels[p];
+            apply_block(panel, B.block(panel.offset, 0, B.rows() - panel.offset, B.cols()), transposed);
+        }
+
+        // C = (I - V T V^T) C 或其转置作用于 C
+        static void apply_block(const Panel &panel, MatrixView<T, Layout::ColMajor> C, bool transposed) {
+            std::size_t jb = panel.t.rows(), k = C.cols();
+            auto V = panel.v.view();
+
+            // W = V^T C
+            ColMatrix w(jb, k);
+            detail::gemm_kernel(T{1}, transpose(V), MatrixView<const T, Layout::ColMajor>(C), T{0}, w.view());
+
+            // W = T^T W 或 T W (T 为上三角, 逐列原地计算)
+            const T *t = panel.t.data();
+            T *wd = w.data();
+            for (std::size_t c = 0; c < k; ++c) {
+                T *col = wd + c * jb;
+                if (transposed) {
+                    for (std::size_t i = jb; i-- > 0;) {
+                        T s{};
+                        for (std::size_t r = 0; r <= i; ++r)
+                            s += t[i * jb + r] * col[r];
+                        col[i] = s;
+                    }
+                } else {
+                    for (std::size_t i = 0; i < jb; ++i) {
+                        T s{};
+                        for (std::size_t r = i; r < jb; ++r)
+                            s += t[r * jb + i] * col[r];
+                        col[i] = s;
+                    }
+                }
+            }
+
+            // C = C - V W
+            detail::gemm_kernel(T{-1}, V, std::as_const(w).view(), T{1}, C);
+        }
+
+        ColMatrix a;// 上三角部分为 R, 严格下三角部分为反射子
+        std::vector<Panel> panels;
+    };
+
+    template<MatrixLike M>
+    QR(const M &) -> QR<typename decltype(const_view(std::declval<M>()))::value_type>;
+
+    // 最小二乘: 返回使 ||A * x - b|| 最小的 x
+    template<MatrixLike M, typename T>
+    std::vector<T> least_squares(const M &matrix, const std::vector<T> &rhs) {
+        return QR<T>(matrix).solve(rhs);
+    }
+
+    template<MatrixLike M, typename T, Layout L>
+    Matrix<T, L> least_squares(const M &matrix, const Matrix<T, L> &rhs) {
+        return QR<T>(matrix).solve(rhs);
+    }
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_QR
@@ -0,0 +1,244 @@
+#ifndef AUT_AP_2024_Spring_HW1_QUANTIZED
+#define AUT_AP_2024_Spring_HW1_QUANTIZED
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__AVX512BW__)
+#include <immintrin.h>
+#endif
+
+#include "instrument.h"
+#include "matrix.h"
+#include "thread_pool.h"
+
+namespace algebra {
+
+    // 可参与量化乘法的元素类型
+    template<typename T>
+    concept QuantizedElement = std::same_as<T, std::int8_t> || std::same_as<T, std::uint8_t> ||
+                               std::same_as<T, std::int16_t>;
+
+    // 仿射量化: real = scale * (q - zero_point)
+    struct QuantParams {
+        float scale = 1.f;
+        std::int32_t zero_point = 0;
+    };
+
+    namespace detail {
+
+        // 打包后每行的长度对齐到该字节数, 补零部分不影响内积
+        constexpr std::size_t kQuantAlign = 64;
+
+        // 每个并行块负责的 C 的行数
+        constexpr std::size_t kQuantRows = 4;
+
+        // 打包的 B^T 分块大小, 使一块留在 L2 缓存中
+        constexpr std::size_t kQuantPanelBytes = std::size_t{1} << 17;
+
+        // 无符号 8 位乘有符号 8 位的内积, len 为 kQuantAlign 的倍数
+        inline std::int32_t dot_u8s8(const std::uint8_t *a, const std::int8_t *b, std::size_t len) {
+#if defined(__AVX512VNNI__) && defined(__AVX512BW__)
+            // vpdpbusd: 每 4 个 u8 * s8 乘积直接累加到 int32, 没有中间饱和
+            __m512i acc = _mm512_setzero_si512();
+            for (std::size_t p = 0; p < len; p += 64)
+                acc = _mm512_dpbusd_epi32(acc, _mm512_loadu_si512(a + p), _mm512_loadu_si512(b + p));
+            return _mm512_reduce_add_epi32(acc);
+#elif defined(__AVX2__)
+            // vpmaddubsw 的 int16 中间结果会饱和 (255 * 127 * 2 > 32767), 因此先扩展为 int16 再用 vpmaddwd
+            __m256i acc = _mm256_setzero_si256();
+            for (std::size_t p = 0; p < len; p += 16) {
+                __m256i va = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + p)));
+                __m256i vb = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + p)));
+                acc = _mm256_add_epi32(acc, _mm256_madd_epi16(va, vb));
+            }
+            __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+            sum = _mm_hadd_epi32(sum, sum);
+            sum = _mm_hadd_epi32(sum, sum);
+            return _mm_cvtsi128_si32(sum);
+#else
+            std::int32_t acc = 0;
+            for (std::size_t p = 0; p < len; ++p)
+                acc += static_cast<std::int32_t>(a[p]) * static_cast<std::int32_t>(b[p]);
+            return acc;
+#endif
+        }
+
+        // 16 位内积, len 为 kQuantAlign / 2 的倍数
+        inline std::int32_t dot_s16(const std::int16_t *a, const std::int16_t *b, std::size_t len) {
+#if defined(__AVX512VNNI__) && defined(__AVX512BW__)
+            __m512i acc = _mm512_setzero_si512();
+            for (std::size_t p = 0; p < len; p += 32)
+                acc = _mm512_dpwssd_epi32(acc, _mm512_loadu_si512(a + p), _mm512_loadu_si512(b + p));
+            return _mm512_reduce_add_epi32(acc);
+#elif defined(__AVX2__)
+            __m256i acc = _mm256_setzero_si256();
+            for (std::size_t p = 0; p < len; p += 16) {
+                __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + p));
+                __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + p));
+                acc = _mm256_add_epi32(acc, _mm256_madd_epi16(va, vb));
+            }
+            __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+            sum = _mm_hadd_epi32(sum, sum);
+            sum = _mm_hadd_epi32(sum, sum);
+            return _mm_cvtsi128_si32(sum);
+#else
+            std::int32_t acc = 0;
+            for (std::size_t p = 0; p < len; ++p)
+                acc += static_cast<std::int32_t>(a[p]) * static_cast<std::int32_t>(b[p]);
+            return acc;
+#endif
+        }
+
+        // 打包后的操作数: 每行 stride 个元素, 并记录每行 (原始长度内) 的元素和
+        template<typename P>
+        struct QuantPacked {
+            std::vector<P> data;
+            std::vector<std::int32_t> sums;
+            std::size_t stride;
+        };
+
+        // 把 op(X) 的 lines 条长度为 len 的线打包为 P, 每个元素加上 shift (8 位有无符号之间的转换)
+        template<typename P, typename G>
+        QuantPacked<P> quant_pack(std::size_t lines, std::size_t len, std::int32_t shift, G get) {
+            constexpr std::size_t lanes = kQuantAlign / sizeof(P);
+            std::size_t stride = (len + lanes - 1) / lanes * lanes;
+            QuantPacked<P> res{std::vector<P>(lines * stride), std::vector<std::int32_t>(lines), stride};
+
+            for (std::size_t l = 0; l < lines; ++l) {
+                P *dst = res.data.data() + l * stride;
+                std::int32_t sum = 0;
+                for (std::size_t p = 0; p < len; ++p) {
+                    std::int32_t v = static_cast<std::int32_t>(get(l, p)) + shift;
+                    dst[p] = static_cast<P>(v);
+                    sum += v;
+                }
+                res.sums[l] = sum;
+            }
+            return res;
+        }
+
+        // C = (A' - za') * (B' - zb'): 内积 - zb' * rowsum(A') - za' * colsum(B') + k * za' * zb'
+        template<typename PA, typename PB, typename Dot>
+        Matrix<std::int32_t> quant_gemm(const QuantPacked<PA> &a, std::int32_t za, const QuantPacked<PB> &b,
+                                        std::int32_t zb, std::size_t k, Dot dot) {
+            std::size_t m = a.sums.size(), n = b.sums.size(), stride = a.stride;
+            Matrix<std::int32_t> res(m, n);
+            std::int32_t *out = res.data();
+            // 修正项用 int64 计算, 只有最终结果需要落在 int32 范围内
+            std::int64_t offset = static_cast<std::int64_t>(k) * za * zb;
+            std::size_t panel = std::max<std::size_t>(1, kQuantPanelBytes / (stride * sizeof(PB)));
+
+            ThreadPool::instance().parallel_for(0, m, kQuantRows, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t j0 = 0; j0 < n; j0 += panel) {
+                    std::size_t j1 = std::min(n, j0 + panel);
+                    for (std::size_t i = lo; i < hi; ++i) {
+                        const PA *row = a.data.data() + i * stride;
+                        std::int64_t row_term = offset - std::int64_t{zb} * a.sums[i];
+                        for (std::size_t j = j0; j < j1; ++j)
+                            out[i * n + j] = static_cast<std::int32_t>(dot(row, b.data.data() + j * stride, stride) +
+                                                                       row_term - std::int64_t{za} * b.sums[j]);
+                    }
+                }
+            });
+            return res;
+        }
+
+        template<typename Q>
+        Q saturate(float value) {
+            float lo = static_cast<float>(std::numeric_limits<Q>::min());
+            float hi = static_cast<float>(std::numeric_limits<Q>::max());
+            return static_cast<Q>(std::clamp(std::nearbyint(value), lo, hi));
+        }
+
+    }// namespace detail
+
+    // 量化矩阵乘法, 以 int32 累加: C = (A - za) * (B - zb).
+    // 两个 8 位操作数统一转换为 u8 x s8 (VNNI 的原生形式), 零点相应平移; 含 int16 时使用 16 位内积.
+    // 每个乘积不超过 2^15 * 2^8 (8 位) 或 2^30 (16 位), 长度 k 过大时 int32 会溢出, 调用方需自行分段.
+    template<MatrixLike MA, MatrixLike MB>
+    Matrix<std::int32_t> quantized_gemm(const MA &matrixA, std::int32_t za, const MB &matrixB, std::int32_t zb) {
+        auto A = const_view(matrixA);
+        auto B = const_view(matrixB);
+        using TA = std::remove_const_t<typename decltype(A)::value_type>;
+        using TB = std::remove_const_t<typename decltype(B)::value_type>;
+        static_assert(QuantizedElement<TA> && QuantizedElement<TB>, "Quantized GEMM requires int8, uint8 or int16 operands.");
+
+        if (A.empty() || B.empty())
+            throw std::invalid_argument("Matrices must not be empty.");
+        if (A.cols() != B.rows())
+            throw std::invalid_argument("Matrix dimension mismatch.");
+
+        std::size_t m = A.rows(), k = A.cols(), n = B.cols();
+        ALGEBRA_TRACE("quantized_gemm", m, n, k, 2.0 * m * n * k,
+                      1.0 * m * k * sizeof(TA) + 1.0 * k * n * sizeof(TB) + 4.0 * m * n);
+        auto get_a = [&](std::size_t i, std::size_t p) { return A(i, p); };
+        auto get_bt = [&](std::size_t j, std::size_t p) { return B(p, j); };
+
+        if constexpr (sizeof(TA) == 1 && sizeof(TB) == 1) {
+            // int8 的 A 加 128 变为 uint8, uint8 的 B 减 128 变为 int8
+            std::int32_t shift_a = std::is_signed_v<TA> ? 128 : 0;
+            std::int32_t shift_b = std::is_signed_v<TB> ? 0 : -128;
+            auto a = detail::quant_pack<std::uint8_t>(m, k, shift_a, get_a);
+            auto b = detail::quant_pack<std::int8_t>(n, k, shift_b, get_bt);
+            return detail::quant_gemm(a, za + shift_a, b, zb + shift_b, k, detail::dot_u8s8);
+        } else {
+            auto a = detail::quant_pack<std::int16_t>(m, k, 0, get_a);
+            auto b = detail::quant_pack<std::int16_t>(n, k, 0, get_bt);
+            return detail::quant_gemm(a, za, b, zb, k, detail::dot_s16);
+        }
+    }
+
+    // 反量化结果: real(C) = scale_a * scale_b * (A - za) * (B - zb)
+    template<MatrixLike MA, MatrixLike MB>
+    Matrix<float> dequantized_multiply(const MA &matrixA, QuantParams qa, const MB &matrixB, QuantParams qb) {
+        Matrix<std::int32_t> acc = quantized_gemm(matrixA, qa.zero_point, matrixB, qb.zero_point);
+        Matrix<float> res(acc.rows(), acc.cols());
+        float scale = qa.scale * qb.scale;
+        const std::int32_t *src = std::as_const(acc).data();
+        float *dst = res.data();
+        for (std::size_t x = 0; x < acc.size(); ++x)
+            dst[x] = scale * static_cast<float>(src[x]);
+        return res;
+    }
+
+    // 重新量化到输出类型: q(C) = round(scale_a * scale_b / scale_c * acc) + zc, 并做饱和
+    template<QuantizedElement Q, MatrixLike MA, MatrixLike MB>
+    Matrix<Q> quantized_multiply(const MA &matrixA, QuantParams qa, const MB &matrixB, QuantParams qb, QuantParams qc) {
+        if (!(qc.scale > 0.f))
+            throw std::invalid_argument("Quantization scale must be positive.");
+
+        Matrix<std::int32_t> acc = quantized_gemm(matrixA, qa.zero_point, matrixB, qb.zero_point);
+        Matrix<Q> res(acc.rows(), acc.cols());
+        float multiplier = qa.scale * qb.scale / qc.scale;
+        const std::int32_t *src = std::as_const(acc).data();
+        Q *dst = res.data();
+        for (std::size_t x = 0; x < acc.size(); ++x)
+            dst[x] = detail::saturate<Q>(multiplier * static_cast<float>(src[x]) + static_cast<float>(qc.zero_point));
+        return res;
+    }
+
+    // 按给定参数量化浮点矩阵: q = clamp(round(x / scale) + zero_point)
+    template<QuantizedElement Q, Layout L>
+    Matrix<Q, L> quantize(const Matrix<float, L> &matrix, QuantParams params) {
+        if (!(params.scale > 0.f))
+            throw std::invalid_argument("Quantization scale must be positive.");
+
+        Matrix<Q, L> res(matrix.rows(), matrix.cols());
+        const float *src = matrix.data();
+        Q *dst = res.data();
+        for (std::size_t x = 0; x < matrix.size(); ++x)
+            dst[x] = detail::saturate<Q>(src[x] / params.scale + static_cast<float>(params.zero_point));
+        return res;
+    }
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_QUANTIZED
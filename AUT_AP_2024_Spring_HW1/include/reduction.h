@@ -0,0 +1,445 @@
+#ifndef AUT_AP_2024_Spring_HW1_REDUCTION
+#define AUT_AP_2024_Spring_HW1_REDUCTION
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "matrix.h"
+#include "thread_pool.h"
+
+namespace algebra {
+
+    // 求和方式: 朴素累加, 两两分治求和 (误差 O(log n)), Kahan 补偿求和 (误差 O(1))
+    enum class Summation { Naive,
+                           Pairwise,
+                           Kahan };
+
+    // 归约方向: Row 把每一行归约为一个值 (结果长度为行数), Column 把每一列归约为一个值
+    enum class Axis { Row,
+                      Column };
+
+    // 矩阵范数: Frobenius, L1 (最大列绝对值和), Inf (最大行绝对值和), Max (最大元素绝对值)
+    enum class Norm { Frobenius,
+                      L1,
+                      Inf,
+                      Max };
+
+    struct ReduceOptions {
+        Summation summation = Summation::Pairwise;
+        // true 时分块只取决于数据大小, 结果与线程数无关; false 时按线程数分块, 调度开销更小
+        bool deterministic = true;
+    };
+
+    namespace detail {
+
+        // 独立累加器的路数, 对应一条 AVX-512 double 向量或两条 AVX2 向量
+        constexpr std::size_t kLanes = 8;
+
+        // 两两求和递归到该长度后改为多路累加
+        constexpr std::size_t kPairwiseBase = 128;
+
+        // 确定性模式下每个并行块的元素数
+        constexpr std::size_t kReduceGrain = std::size_t{1} << 15;
+
+        // 非确定性模式下每个并行块的最少元素数
+        constexpr std::size_t kReduceMinGrain = std::size_t{1} << 12;
+
+        template<typename T>
+        struct real_type {
+            using type = std::conditional_t<std::is_integral_v<T>, double, T>;
+        };
+
+        template<typename T>
+        struct real_type<std::complex<T>> {
+            using type = T;
+        };
+
+        // 范数与整数求和的结果类型, 复数取其实数类型
+        template<typename T>
+        using real_t = typename real_type<T>::type;
+
+        template<typename T>
+        real_t<T> abs_value(T x) {
+            if constexpr (std::is_unsigned_v<T>)
+                return static_cast<real_t<T>>(x);
+            else if constexpr (is_complex_v<T>)
+                return std::abs(x);
+            else
+                return std::abs(static_cast<real_t<T>>(x));
+        }
+
+        // 按固定顺序合并各路累加器: ((a0 + a1) + (a2 + a3)) + ...
+        template<typename A>
+        A combine_lanes(A *acc) {
+            for (std::size_t width = kLanes / 2; width > 0; width /= 2)
+                for (std::size_t l = 0; l < width; ++l)
+                    acc[l] += acc[l + width];
+            return acc[0];
+        }
+
+        // 对 g(lo) ... g(hi - 1) 多路累加, 各路互不依赖, 编译器可以向量化
+        template<typename A, typename G>
+        A sum_lanes(std::size_t lo, std::size_t hi, G g) {
+            A acc[kLanes]{};
+            std::size_t i = lo;
+            for (; i + kLanes <= hi; i += kLanes)
+                for (std::size_t l = 0; l < kLanes; ++l)
+                    acc[l] += g(i + l);
+            for (std::size_t l = 0; i < hi; ++i, ++l)
+                acc[l] += g(i);
+            return combine_lanes(acc);
+        }
+
+        template<typename A, typename G>
+        A sum_pairwise(std::size_t lo, std::size_t hi, G g) {
+            if (hi - lo <= kPairwiseBase)
+                return sum_lanes<A>(lo, hi, g);
+            std::size_t mid = lo + (hi - lo) / 2 / kLanes * kLanes;
+            return sum_pairwise<A>(lo, mid, g) + sum_pairwise<A>(mid, hi, g);
+        }
+
+        template<typename A, typename G>
+        A sum_kahan(std::size_t lo, std::size_t hi, G g) {
+            A sum[kLanes]{}, comp[kLanes]{};
+            auto add = [&](std::size_t l, A value) {
+                A y = value - comp[l];
+                A t = sum[l] + y;
+                comp[l] = (t - sum[l]) - y;
+                sum[l] = t;
+            };
+
+            std::size_t i = lo;
+            for (; i + kLanes <= hi; i += kLanes)
+                for (std::size_t l = 0; l < kLanes; ++l)
+                    add(l, g(i + l));
+            for (std::size_t l = 0; i < hi; ++i, ++l)
+                add(l, g(i));
+
+            // 各路的和同样用补偿求和合并
+            A total{}, c{};
+            for (std::size_t l = 0; l < kLanes; ++l) {
+                A y = (sum[l] - comp[l]) - c;
+                A t = total + y;
+                c = (t - total) - y;
+                total = t;
+            }
+            return total;
+        }
+
+        template<typename A, typename G>
+        A sum_range(std::size_t lo, std::size_t hi, Summation method, G g) {
+            switch (method) {
+                case Summation::Naive:
+                    return sum_lanes<A>(lo, hi, g);
+                case Summation::Kahan:
+                    return sum_kahan<A>(lo, hi, g);
+                default:
+                    return sum_pairwise<A>(lo, hi, g);
+            }
+        }
+
+        inline std::size_t reduce_grain(std::size_t n, const ReduceOptions &opts) {
+            if (opts.deterministic)
+                return kReduceGrain;
+            std::size_t threads = ThreadPool::instance().concurrency();
+            return std::max(kReduceMinGrain, (n + threads - 1) / threads);
+        }
+
+        // 对视图中所有元素 f(x) 求和: 按主维度把视图看作若干条连续的线
+        template<typename A, typename T, Layout L, typename F>
+        A sum_all(MatrixView<const T, L> v, const ReduceOptions &opts, F f) {
+            std::size_t lines = L == Layout::RowMajor ? v.rows() : v.cols();
+            std::size_t len = L == Layout::RowMajor ? v.cols() : v.rows();
+            if (v.contiguous()) {
+                len *= lines;
+                lines = 1;
+            }
+
+            std::vector<A> partials;
+            if (lines == 1) {
+                // 连续数据: 按固定大小分块并行, 再按块的顺序合并
+                const T *x = v.data();
+                std::size_t grain = reduce_grain(len, opts);
+                partials.resize((len + grain - 1) / grain);
+                ThreadPool::instance().parallel_for(0, len, grain, [&](std::size_t lo, std::size_t hi) {
+                    partials[lo / grain] = sum_range<A>(lo, hi, opts.summation, [x, &f](std::size_t i) { return f(x[i]); });
+                });
+            } else {
+                // 跨步视图: 每条线单独求和, 再合并各线的结果
+                partials.resize(lines);
+                std::size_t grain = std::max<std::size_t>(1, reduce_grain(lines * len, opts) / len);
+                ThreadPool::instance().parallel_for(0, lines, grain, [&](std::size_t lo, std::size_t hi) {
+                    for (std::size_t l = lo; l < hi; ++l) {
+                        const T *x = v.data() + l * v.ld();
+                        partials[l] = sum_range<A>(0, len, opts.summation, [x, &f](std::size_t i) { return f(x[i]); });
+                    }
+                });
+            }
+
+            return sum_range<A>(0, partials.size(), opts.summation, [&](std::size_t i) { return partials[i]; });
+        }
+
+        // 把第 [l0, l1) 条线逐元素累加到 dst 的 [lo, hi) 上 (两两分治合并各线)
+        template<typename A, typename T, Layout L, typename F>
+        void sum_lines_pairwise(MatrixView<const T, L> v, std::size_t l0, std::size_t l1,
+                                std::size_t lo, std::size_t hi, A *dst, F &f) {
+            if (l1 - l0 <= kLanes) {
+                for (std::size_t l = l0; l < l1; ++l) {
+                    const T *x = v.data() + l * v.ld();
+                    for (std::size_t i = lo; i < hi; ++i)
+                        dst[i - lo] += f(x[i]);
+                }
+                return;
+            }
+
+            std::size_t mid = l0 + (l1 - l0) / 2;
+            std::vector<A> tmp(hi - lo);
+            sum_lines_pairwise(v, l0, mid, lo, hi, dst, f);
+            sum_lines_pairwise(v, mid, l1, lo, hi, tmp.data(), f);
+            for (std::size_t i = 0; i < hi - lo; ++i)
+                dst[i] += tmp[i];
+        }
+
+        // 沿某一方向求和; 若归约方向与存储方向一致则逐线求和, 否则跨线逐元素累加
+        template<typename A, typename T, Layout L, typename F>
+        std::vector<A> sum_axis(MatrixView<const T, L> v, Axis axis, const ReduceOptions &opts, F f) {
+            std::size_t lines = L == Layout::RowMajor ? v.rows() : v.cols();
+            std::size_t len = L == Layout::RowMajor ? v.cols() : v.rows();
+            bool along = (axis == Axis::Row) == (L == Layout::RowMajor);
+
+            auto &pool = ThreadPool::instance();
+            std::size_t grain = reduce_grain(lines * len, opts);
+
+            if (along) {
+                std::vector<A> res(lines);
+                pool.parallel_for(0, lines, std::max<std::size_t>(1, grain / len), [&](std::size_t lo, std::size_t hi) {
+                    for (std::size_t l = lo; l < hi; ++l) {
+                        const T *x = v.data() + l * v.ld();
+                        res[l] = sum_range<A>(0, len, opts.summation, [x, &f](std::size_t i) { return f(x[i]); });
+                    }
+                });
+                return res;
+            }
+
+            std::vector<A> res(len);
+            std::size_t block = std::max(kLanes, grain / lines / kLanes * kLanes);
+            pool.parallel_for(0, len, block, [&](std::size_t lo, std::size_t hi) {
+                A *dst = res.data() + lo;
+                if (opts.summation == Summation::Pairwise) {
+                    sum_lines_pairwise(v, 0, lines, lo, hi, dst, f);
+                } else if (opts.summation == Summation::Kahan) {
+                    std::vector<A> comp(hi - lo);
+                    for (std::size_t l = 0; l < lines; ++l) {
+                        const T *x = v.data() + l * v.ld();
+                        for (std::size_t i = lo; i < hi; ++i) {
+                            A y = f(x[i]) - comp[i - lo];
+                            A t = dst[i - lo] + y;
+                            comp[i - lo] = (t - dst[i - lo]) - y;
+                            dst[i - lo] = t;
+                        }
+                    }
+                } else {
+                    for (std::size_t l = 0; l < lines; ++l) {
+                        const T *x = v.data() + l * v.ld();
+                        for (std::size_t i = lo; i < hi; ++i)
+                            dst[i - lo] += f(x[i]);
+                    }
+                }
+            });
+            return res;
+        }
+
+        // 对所有元素做满足交换律与结合律的折叠 (min / max), 顺序不影响结果
+        template<typename T, Layout L, typename Op>
+        T fold_all(MatrixView<const T, L> v, Op op) {
+            std::size_t lines = L == Layout::RowMajor ? v.rows() : v.cols();
+            std::size_t len = L == Layout::RowMajor ? v.cols() : v.rows();
+
+            std::vector<T> partials(lines);
+            ThreadPool::instance().parallel_for(0, lines, std::max<std::size_t>(1, kReduceGrain / len), [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t l = lo; l < hi; ++l) {
+                    const T *x = v.data() + l * v.ld();
+                    T acc[kLanes];
+                    std::fill_n(acc, kLanes, x[0]);
+                    std::size_t i = 0;
+                    for (; i + kLanes <= len; i += kLanes)
+                        for (std::size_t k = 0; k < kLanes; ++k)
+                            acc[k] = op(acc[k], x[i + k]);
+                    for (; i < len; ++i)
+                        acc[0] = op(acc[0], x[i]);
+                    for (std::size_t k = 1; k < kLanes; ++k)
+                        acc[0] = op(acc[0], acc[k]);
+                    partials[l] = acc[0];
+                }
+            });
+
+            return std::reduce(partials.begin() + 1, partials.end(), partials[0], op);
+        }
+
+        template<typename T, Layout L, typename Op>
+        std::vector<T> fold_axis(MatrixView<const T, L> v, Axis axis, Op op) {
+            std::size_t lines = L == Layout::RowMajor ? v.rows() : v.cols();
+            std::size_t len = L == Layout::RowMajor ? v.cols() : v.rows();
+            bool along = (axis == Axis::Row) == (L == Layout::RowMajor);
+
+            if (along) {
+                std::vector<T> res(lines);
+                ThreadPool::instance().parallel_for(0, lines, std::max<std::size_t>(1, kReduceGrain / len), [&](std::size_t lo, std::size_t hi) {
+                    for (std::size_t l = lo; l < hi; ++l) {
+                        const T *x = v.data() + l * v.ld();
+                        res[l] = std::reduce(x + 1, x + len, x[0], op);
+                    }
+                });
+                return res;
+            }
+
+            std::vector<T> res(v.data(), v.data() + len);
+            std::size_t block = std::max(kLanes, kReduceGrain / lines / kLanes * kLanes);
+            ThreadPool::instance().parallel_for(0, len, block, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t l = 1; l < lines; ++l) {
+                    const T *x = v.data() + l * v.ld();
+                    for (std::size_t i = lo; i < hi; ++i)
+                        res[i] = op(res[i], x[i]);
+                }
+            });
+            return res;
+        }
+
+        template<typename T>
+        struct Min {
+            T operator()(T a, T b) const { return b < a ? b : a; }
+        };
+
+        template<typename T>
+        struct Max {
+            T operator()(T a, T b) const { return a < b ? b : a; }
+        };
+
+        template<typename V>
+        void check_not_empty(const V &v) {
+            if (v.empty())
+                throw std::invalid_argument("Matrices must not be empty.");
+        }
+
+    }// namespace detail
+
+    // 所有元素之和
+    template<MatrixLike M>
+    auto sum(const M &matrix, ReduceOptions opts = {}) {
+        auto v = const_view(matrix);
+        using T = typename decltype(v)::value_type;
+        detail::check_not_empty(v);
+        return detail::sum_all<T>(v, opts, [](T x) { return x; });
+    }
+
+    // 沿 axis 求和, 例如 Axis::Row 得到每一行的和
+    template<MatrixLike M>
+    auto sum(const M &matrix, Axis axis, ReduceOptions opts = {}) {
+        auto v = const_view(matrix);
+        using T = typename decltype(v)::value_type;
+        detail::check_not_empty(v);
+        return detail::sum_axis<T>(v, axis, opts, [](T x) { return x; });
+    }
+
+    template<MatrixLike M>
+    auto min(const M &matrix) {
+        auto v = const_view(matrix);
+        using T = typename decltype(v)::value_type;
+        detail::check_not_empty(v);
+        return detail::fold_all(v, detail::Min<T>{});
+    }
+
+    template<MatrixLike M>
+    auto min(const M &matrix, Axis axis) {
+        auto v = const_view(matrix);
+        using T = typename decltype(v)::value_type;
+        detail::check_not_empty(v);
+        return detail::fold_axis(v, axis, detail::Min<T>{});
+    }
+
+    template<MatrixLike M>
+    auto max(const M &matrix) {
+        auto v = const_view(matrix);
+        using T = typename decltype(v)::value_type;
+        detail::check_not_empty(v);
+        return detail::fold_all(v, detail::Max<T>{});
+    }
+
+    template<MatrixLike M>
+    auto max(const M &matrix, Axis axis) {
+        auto v = const_view(matrix);
+        using T = typename decltype(v)::value_type;
+        detail::check_not_empty(v);
+        return detail::fold_axis(v, axis, detail::Max<T>{});
+    }
+
+    template<MatrixLike M>
+    auto norm(const M &matrix, Norm type = Norm::Frobenius, ReduceOptions opts = {}) {
+        auto v = const_view(matrix);
+        using T = typename decltype(v)::value_type;
+        using R = detail::real_t<T>;
+        detail::check_not_empty(v);
+
+        auto abs = [](T x) { return detail::abs_value(x); };
+
+        switch (type) {
+            case Norm::L1: {
+                auto col_sums = detail::sum_axis<R>(v, Axis::Column, opts, abs);
+                return *std::max_element(col_sums.begin(), col_sums.end());
+            }
+            case Norm::Inf: {
+                auto row_sums = detail::sum_axis<R>(v, Axis::Row, opts, abs);
+                return *std::max_element(row_sums.begin(), row_sums.end());
+            }
+            case Norm::Max:
+                if constexpr (detail::is_complex_v<T>) {
+                    // 复数没有序关系, 直接比较模长
+                    R res{};
+                    for (std::size_t i = 0; i < v.rows(); ++i)
+                        for (std::size_t j = 0; j < v.cols(); ++j)
+                            res = std::max(res, std::abs(v(i, j)));
+                    return res;
+                } else {
+                    return std::max(detail::abs_value(detail::fold_all(v, detail::Max<T>{})),
+                                    detail::abs_value(detail::fold_all(v, detail::Min<T>{})));
+                }
+            default:
+                return std::sqrt(detail::sum_all<R>(v, opts, [](T x) {
+                    R a = detail::abs_value(x);
+                    return a * a;
+                }));
+        }
+    }
+
+    // 向量内积
+    template<typename T>
+    T dot(std::span<const T> x, std::span<const T> y, ReduceOptions opts = {}) {
+        if (x.size() != y.size())
+            throw std::invalid_argument("Vector dimension mismatch.");
+
+        std::size_t n = x.size();
+        std::size_t grain = detail::reduce_grain(n, opts);
+        std::vector<T> partials((n + grain - 1) / grain);
+
+        ThreadPool::instance().parallel_for(0, n, grain, [&](std::size_t lo, std::size_t hi) {
+            partials[lo / grain] = detail::sum_range<T>(lo, hi, opts.summation, [&](std::size_t i) { return x[i] * y[i]; });
+        });
+
+        return detail::sum_range<T>(0, partials.size(), opts.summation, [&](std::size_t i) { return partials[i]; });
+    }
+
+    template<typename T>
+    T dot(const std::vector<T> &x, const std::vector<T> &y, ReduceOptions opts = {}) {
+        return dot(std::span<const T>(x), std::span<const T>(y), opts);
+    }
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_REDUCTION
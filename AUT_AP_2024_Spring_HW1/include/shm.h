@@ -0,0 +1,340 @@
+#ifndef AUT_AP_2024_Spring_HW1_SHM
+#define AUT_AP_2024_Spring_HW1_SHM
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __has_include(<sys/mman.h>) && __has_include(<sys/wait.h>) && __has_include(<sched.h>)
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define ALGEBRA_HAS_PROCESSES 1
+#endif
+
+#include "algebra.h"
+#include "instrument.h"
+#include "kernel.h"
+#include "matrix.h"
+#include "thread_pool.h"
+#include "tuning.h"
+#include "unchecked.h"
+
+namespace algebra {
+
+    // 多进程运算的参数
+    struct ProcessOptions {
+        std::size_t processes = 0;// 工作进程数, 0 表示 ThreadPool::default_concurrency()
+        std::size_t tile = 256;   // 乘法输出块的边长
+        bool pin = true;          // 把工作进程绑定到所在 NUMA 节点的 CPU 上
+    };
+
+    // 存放在 POSIX 共享内存中的行主序矩阵, 由 fork 出的工作进程直接读写.
+    // 共享内存对象创建后立即 unlink, 只能通过映射 (及 fork 继承) 访问, 进程异常退出也不会遗留对象.
+    // 新矩阵的元素为零 (新的共享内存页由内核清零), 构造时不写入, 页面在第一次写入它的进程所在的 NUMA 节点上分配.
+    // 没有 fork/mmap 的平台退化为普通内存, 运算在当前进程中执行.
+    template<typename T>
+        requires(std::is_arithmetic_v<T> || detail::is_complex_v<T>)
+    class SharedMatrix {
+    public:
+        using value_type = T;
+        static constexpr Layout layout = Layout::RowMajor;
+
+        SharedMatrix() = default;
+
+        SharedMatrix(std::size_t rows, std::size_t cols)
+            : rows_{rows}, cols_{cols}, data_{allocate(rows * cols)} {}
+
+        // 复制任意存储顺序的矩阵
+        template<MatrixLike M>
+        explicit SharedMatrix(const M &matrix)
+            : SharedMatrix(const_view(matrix).rows(), const_view(matrix).cols()) {
+            detail::copy_blocked(const_view(matrix), view());
+        }
+
+        SharedMatrix(SharedMatrix &&other) noexcept
+            : rows_{std::exchange(other.rows_, 0)}, cols_{std::exchange(other.cols_, 0)},
+              data_{std::exchange(other.data_, nullptr)} {}
+
+        SharedMatrix &operator=(SharedMatrix &&other) noexcept {
+            if (this != &other) {
+                release();
+                rows_ = std::exchange(other.rows_, 0);
+                cols_ = std::exchange(other.cols_, 0);
+                data_ = std::exchange(other.data_, nullptr);
+            }
+            return *this;
+        }
+
+        SharedMatrix(const SharedMatrix &) = delete;
+        SharedMatrix &operator=(const SharedMatrix &) = delete;
+
+        ~SharedMatrix() { release(); }
+
+        T &operator()(std::size_t i, std::size_t j) { return data_[i * cols_ + j]; }
+        const T &operator()(std::size_t i, std::size_t j) const { return data_[i * cols_ + j]; }
+
+        MatrixView<T> view() { return {data_, rows_, cols_}; }
+        MatrixView<const T> view() const { return {data_, rows_, cols_}; }
+
+        T *data() { return data_; }
+        const T *data() const { return data_; }
+        std::size_t rows() const { return rows_; }
+        std::size_t cols() const { return cols_; }
+        std::size_t size() const { return rows_ * cols_; }
+        bool empty() const { return rows_ == 0 || cols_ == 0; }
+
+        // 复制到普通 (进程私有) 矩阵
+        Matrix<T> to_matrix() const {
+            Matrix<T> res(rows_, cols_);
+            std::copy_n(data_, size(), res.data());
+            return res;
+        }
+
+    private:
+        static T *allocate(std::size_t count) {
+            if (count == 0)
+                return nullptr;
+#ifdef ALGEBRA_HAS_PROCESSES
+            static std::atomic<unsigned> counter{0};
+            std::string name = "/algebra-" + std::to_string(::getpid()) + "-" + std::to_string(counter++);
+            int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+            if (fd < 0)
+                throw std::runtime_error("Cannot create shared memory: " + std::string(std::strerror(errno)));
+            ::shm_unlink(name.c_str());
+
+            std::size_t bytes = count * sizeof(T);
+            if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+                ::close(fd);
+                throw std::runtime_error("Cannot resize shared memory: " + std::string(std::strerror(errno)));
+            }
+            void *p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (p == MAP_FAILED)
+                throw std::runtime_error("Cannot map shared memory: " + std::string(std::strerror(errno)));
+            return static_cast<T *>(p);
+#else
+            return new T[count]();
+#endif
+        }
+
+        void release() {
+            if (!data_)
+                return;
+#ifdef ALGEBRA_HAS_PROCESSES
+            ::munmap(data_, size() * sizeof(T));
+#else
+            delete[] data_;
+#endif
+            data_ = nullptr;
+        }
+
+        std::size_t rows_{}, cols_{};
+        T *data_{};
+    };
+
+    template<typename T>
+    MatrixView<const T> const_view(const SharedMatrix<T> &matrix) {
+        return matrix.view();
+    }
+
+    namespace detail {
+
+        // "0-3,8,10-11" 形式的 CPU 列表
+        inline std::vector<int> parse_cpu_list(std::string_view text) {
+            std::vector<int> cpus;
+            while (!text.empty()) {
+                std::size_t comma = text.find(',');
+                std::string item(trim(text.substr(0, comma)));
+                text = comma == std::string_view::npos ? std::string_view{} : text.substr(comma + 1);
+                if (item.empty())
+                    continue;
+                std::size_t dash = item.find('-');
+                int lo = std::stoi(item.substr(0, dash));
+                int hi = dash == std::string::npos ? lo : std::stoi(item.substr(dash + 1));
+                for (int c = lo; c <= hi; ++c)
+                    cpus.push_back(c);
+            }
+            return cpus;
+        }
+
+#ifdef ALGEBRA_HAS_PROCESSES
+        // 各 NUMA 节点上当前进程允许使用的 CPU; 读不到拓扑时所有允许的 CPU 作为一个节点
+        inline std::vector<std::vector<int>> numa_nodes() {
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+            ::sched_getaffinity(0, sizeof allowed, &allowed);
+
+            std::vector<std::pair<int, std::vector<int>>> nodes;
+            std::error_code ec;
+            for (const auto &entry: std::filesystem::directory_iterator("/sys/devices/system/node", ec)) {
+                std::string name = entry.path().filename().string();
+                if (!name.starts_with("node") || name.size() == 4 ||
+                    !std::all_of(name.begin() + 4, name.end(), [](char c) { return c >= '0' && c <= '9'; }))
+                    continue;
+                std::ifstream in(entry.path() / "cpulist");
+                std::string list;
+                std::getline(in, list);
+                std::vector<int> cpus;
+                for (int c: parse_cpu_list(list))
+                    if (c >= 0 && c < CPU_SETSIZE && CPU_ISSET(c, &allowed))
+                        cpus.push_back(c);
+                if (!cpus.empty())
+                    nodes.emplace_back(std::stoi(name.substr(4)), std::move(cpus));
+            }
+            std::sort(nodes.begin(), nodes.end());
+
+            std::vector<std::vector<int>> res;
+            for (auto &[id, cpus]: nodes)
+                res.push_back(std::move(cpus));
+            if (res.empty()) {
+                res.emplace_back();
+                for (int c = 0; c < CPU_SETSIZE; ++c)
+                    if (CPU_ISSET(c, &allowed))
+                        res.back().push_back(c);
+            }
+            return res;
+        }
+
+        inline void pin_to(const std::vector<int> &cpus) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int c: cpus)
+                CPU_SET(c, &set);
+            ::sched_setaffinity(0, sizeof set, &set);
+        }
+#endif
+
+        // 把 [0, items) 切成连续的区间, 在 fork 出的工作进程中调用 fn(lo, hi), 全部结束后返回.
+        // 相邻的区间分给同一 NUMA 节点上的进程. 子进程只能做单线程计算:
+        // fork 只复制调用线程, 父进程的线程池在子进程中不可用. 只有一个进程时直接在当前进程中计算.
+        template<typename F>
+        void run_processes(std::size_t items, const ProcessOptions &options, F &&fn) {
+            std::size_t processes = options.processes ? options.processes : ThreadPool::default_concurrency();
+            processes = std::min(processes, items);
+#ifdef ALGEBRA_HAS_PROCESSES
+            if (processes <= 1) {
+                fn(std::size_t{0}, items);
+                return;
+            }
+
+            // 在父进程中完成 tuning() 的静态初始化, 子进程不会卡在其他线程持有的初始化锁上.
+            // 子进程只调用串行的 GEMM (parallel = false) 与逐元素运算, 不会访问 ThreadPool::instance()
+            tuning();
+            std::vector<std::vector<int>> nodes = numa_nodes();
+
+            std::vector<pid_t> children;
+            std::string failure;
+            for (std::size_t p = 0; p < processes; ++p) {
+                pid_t pid = ::fork();
+                if (pid < 0) {
+                    failure = "Cannot fork worker process: " + std::string(std::strerror(errno));
+                    break;
+                }
+                if (pid == 0) {
+                    int status = 0;
+                    try {
+                        if (options.pin)
+                            pin_to(nodes[p * nodes.size() / processes]);
+                        fn(items * p / processes, items * (p + 1) / processes);
+                    } catch (...) {
+                        status = 1;
+                    }
+                    // 不执行父进程的静态析构和 atexit 处理
+                    ::_exit(status);
+                }
+                children.push_back(pid);
+            }
+
+            for (pid_t pid: children) {
+                int status = 0;
+                while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+                if (failure.empty() && (!WIFEXITED(status) || WEXITSTATUS(status) != 0))
+                    failure = "Worker process failed.";
+            }
+            if (!failure.empty())
+                throw std::runtime_error(failure);
+#else
+            static_cast<void>(options);
+            if (processes > 0)
+                fn(std::size_t{0}, items);
+#endif
+        }
+
+        template<ElementOp Op, typename T>
+        SharedMatrix<T> elementwise_processes(const SharedMatrix<T> &a, const SharedMatrix<T> &b,
+                                              const ProcessOptions &options) {
+            if (a.empty() || b.empty())
+                throw std::invalid_argument("Matrices must not be empty.");
+            if (a.rows() != b.rows() || a.cols() != b.cols())
+                throw std::invalid_argument("Matrix dimension mismatch.");
+            ALGEBRA_TRACE(Op == ElementOp::Product ? "hadamard_product (processes)" : "sum_sub (processes)",
+                          a.rows(), a.cols(), 1, a.size(), 3.0 * a.size() * sizeof(T));
+
+            SharedMatrix<T> res(a.rows(), a.cols());
+            MatrixView<T> out = res.view();
+            run_processes(a.rows(), options, [&](std::size_t lo, std::size_t hi) {
+                unchecked::elementwise<Op>(a.view().block(lo, 0, hi - lo, a.cols()), b.view().block(lo, 0, hi - lo, b.cols()),
+                                           out.block(lo, 0, hi - lo, out.cols()));
+            });
+            return res;
+        }
+
+    }// namespace detail
+
+    // 多进程矩阵乘法: 输出按 tile x tile 的块划分, 每个工作进程用分块内核计算一段连续的块,
+    // 直接写入共享的结果矩阵, 不需要再汇总或复制. fork 的开销在毫秒级, 只适合大矩阵.
+    template<typename T>
+    SharedMatrix<T> multiply(const SharedMatrix<T> &matrixA, const SharedMatrix<T> &matrixB, ProcessOptions options = {}) {
+        if (matrixA.empty() || matrixB.empty())
+            throw std::invalid_argument("Matrices must not be empty.");
+        if (matrixA.cols() != matrixB.rows())
+            throw std::invalid_argument("Matrix dimension mismatch.");
+
+        std::size_t m = matrixA.rows(), k = matrixA.cols(), n = matrixB.cols();
+        ALGEBRA_TRACE("multiply (processes)", m, n, k, 2.0 * m * n * k, (1.0 * m * k + 1.0 * k * n + 1.0 * m * n) * sizeof(T));
+
+        SharedMatrix<T> res(m, n);
+        MatrixView<T> out = res.view();
+        std::size_t tile = std::max<std::size_t>(options.tile, 1);
+        std::size_t tile_cols = (n + tile - 1) / tile;
+        detail::run_processes((m + tile - 1) / tile * tile_cols, options, [&](std::size_t lo, std::size_t hi) {
+            for (std::size_t t = lo; t < hi; ++t) {
+                std::size_t i0 = t / tile_cols * tile, j0 = t % tile_cols * tile;
+                std::size_t rows = std::min(tile, m - i0), cols = std::min(tile, n - j0);
+                detail::gemm_kernel(T{1}, matrixA.view().block(i0, 0, rows, k), matrixB.view().block(0, j0, k, cols),
+                                    T{0}, out.block(i0, j0, rows, cols), false);
+            }
+        });
+        return res;
+    }
+
+    template<typename T>
+    SharedMatrix<T> sum_sub(const SharedMatrix<T> &matrixA, const SharedMatrix<T> &matrixB,
+                            std::optional<std::string> operation = "sum", ProcessOptions options = {}) {
+        if (operation.value() == "sub")
+            return detail::elementwise_processes<ElementOp::Sub>(matrixA, matrixB, options);
+        return detail::elementwise_processes<ElementOp::Sum>(matrixA, matrixB, options);
+    }
+
+    template<typename T>
+    SharedMatrix<T> hadamard_product(const SharedMatrix<T> &matrixA, const SharedMatrix<T> &matrixB, ProcessOptions options = {}) {
+        return detail::elementwise_processes<ElementOp::Product>(matrixA, matrixB, options);
+    }
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_SHM
@@ -0,0 +1,92 @@
+#ifndef AUT_AP_2024_Spring_HW1_SPARSE
+#define AUT_AP_2024_Spring_HW1_SPARSE
+
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "matrix.h"
+#include "thread_pool.h"
+
+namespace algebra {
+
+    namespace detail {
+
+        // 稀疏矩阵乘向量时每个任务处理的行数
+        inline constexpr std::size_t kSparseRowGrain = 1024;
+
+    }// namespace detail
+
+    // 压缩行存储 (CSR) 的稀疏矩阵: 第 i 行的元素为 values[row_ptr[i], row_ptr[i + 1]),
+    // 列号在 col_index 中按升序排列. 允许重复的坐标, 它们在乘法和转换时相加.
+    template<typename T>
+    class CsrMatrix {
+    public:
+        using value_type = T;
+
+        CsrMatrix() : row_ptr_(1, 0) {}
+
+        CsrMatrix(std::size_t rows, std::size_t cols, std::vector<std::size_t> row_ptr,
+                  std::vector<std::size_t> col_index, std::vector<T> values)
+            : rows_{rows}, cols_{cols}, row_ptr_{std::move(row_ptr)}, col_index_{std::move(col_index)},
+              values_{std::move(values)} {
+            if (row_ptr_.size() != rows_ + 1 || row_ptr_.front() != 0 || row_ptr_.back() != values_.size() ||
+                col_index_.size() != values_.size())
+                throw std::invalid_argument("Inconsistent CSR arrays.");
+            for (std::size_t i = 0; i < rows_; ++i)
+                if (row_ptr_[i] > row_ptr_[i + 1])
+                    throw std::invalid_argument("Inconsistent CSR arrays.");
+            for (std::size_t c: col_index_)
+                if (c >= cols_)
+                    throw std::invalid_argument("CSR column index out of range.");
+        }
+
+        std::size_t rows() const { return rows_; }
+        std::size_t cols() const { return cols_; }
+        std::size_t nonzeros() const { return values_.size(); }
+
+        const std::vector<std::size_t> &row_ptr() const { return row_ptr_; }
+        const std::vector<std::size_t> &col_index() const { return col_index_; }
+        const std::vector<T> &values() const { return values_; }
+
+        template<Layout L = Layout::RowMajor>
+        Matrix<T, L> to_dense() const {
+            Matrix<T, L> res(rows_, cols_);
+            for (std::size_t i = 0; i < rows_; ++i)
+                for (std::size_t p = row_ptr_[i]; p < row_ptr_[i + 1]; ++p)
+                    res(i, col_index_[p]) += values_[p];
+            return res;
+        }
+
+    private:
+        std::size_t rows_{}, cols_{};
+        std::vector<std::size_t> row_ptr_;
+        std::vector<std::size_t> col_index_;
+        std::vector<T> values_;
+    };
+
+    // 稀疏矩阵乘向量, 按行并行
+    template<typename T>
+    std::vector<T> multiply(const CsrMatrix<T> &matrix, const std::vector<T> &x) {
+        if (x.size() != matrix.cols())
+            throw std::invalid_argument("Matrix and vector dimensions do not match for multiplication.");
+
+        std::vector<T> y(matrix.rows());
+        const auto &ptr = matrix.row_ptr();
+        const auto &col = matrix.col_index();
+        const auto &val = matrix.values();
+        ThreadPool::instance().parallel_for(0, matrix.rows(), detail::kSparseRowGrain, [&](std::size_t lo, std::size_t hi) {
+            for (std::size_t i = lo; i < hi; ++i) {
+                T sum{};
+                for (std::size_t p = ptr[i]; p < ptr[i + 1]; ++p)
+                    sum += val[p] * x[col[p]];
+                y[i] = sum;
+            }
+        });
+        return y;
+    }
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_SPARSE
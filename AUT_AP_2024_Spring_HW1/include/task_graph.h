@@ -0,0 +1,391 @@
+#ifndef AUT_AP_2024_Spring_HW1_TASK_GRAPH
+#define AUT_AP_2024_Spring_HW1_TASK_GRAPH
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "kernel.h"
+#include "lu.h"
+#include "matrix.h"
+#include "thread_pool.h"
+#include "unchecked.h"
+
+namespace algebra {
+
+    namespace detail {
+
+        // 按形状回收中间结果的缓冲区
+        template<typename T>
+        class BufferPool {
+        public:
+            Matrix<T> acquire(std::size_t rows, std::size_t cols) {
+                {
+                    std::lock_guard lock{mutex};
+                    auto &free = buffers[{rows, cols}];
+                    while (!free.empty()) {
+                        Matrix<T> m = std::move(free.back());
+                        free.pop_back();
+                        // 仍与用户持有的副本共享的缓冲区不能再写入
+                        if (m.unique())
+                            return m;
+                    }
+                    ++allocated;
+                }
+                return Matrix<T>(rows, cols);
+            }
+
+            void release(Matrix<T> matrix) {
+                if (matrix.empty())
+                    return;
+                std::lock_guard lock{mutex};
+                buffers[{matrix.rows(), matrix.cols()}].push_back(std::move(matrix));
+            }
+
+            std::size_t allocations() const {
+                std::lock_guard lock{mutex};
+                return allocated;
+            }
+
+        private:
+            mutable std::mutex mutex;
+            std::map<std::pair<std::size_t, std::size_t>, std::vector<Matrix<T>>> buffers;
+            std::size_t allocated{0};
+        };
+
+    }// namespace detail
+
+    // 由矩阵运算组成的有向无环图, 在线程池上执行.
+    // 节点的输出按 tile_rows 行切成行块, 每个行块是一个任务: 逐元素运算和乘法左因子只依赖输入的同一行块,
+    // 因此下游节点的行块在对应的上游行块完成后即可开始, 不必等整个上游节点; 互不依赖的节点并发执行.
+    // 中间结果在所有使用者完成后回收, 供之后的节点复用; 没有使用者的节点 (以及 keep 标记的节点) 的结果保留.
+    //
+    //   TaskGraph<double> g;
+    //   auto a = g.input(A), b = g.input(B), c = g.input(C), d = g.input(D);
+    //   auto r = g.multiply(g.inverse(g.sum_sub(g.multiply(g.transpose(a), b), c)), d);
+    //   g.run();
+    //   const Matrix<double> &res = g.result(r);
+    template<typename T>
+    class TaskGraph {
+    public:
+        // 图中节点的句柄, 只在创建它的图中有效
+        class Node {
+        public:
+            Node() = default;
+
+        private:
+            friend class TaskGraph;
+            explicit Node(std::size_t id) : id{id} {}
+            std::size_t id{};
+        };
+
+        explicit TaskGraph(std::size_t tile_rows = 64, ThreadPool &pool = ThreadPool::instance())
+            : tile_rows{std::max<std::size_t>(tile_rows, 1)}, pool{pool} {}
+
+        TaskGraph(const TaskGraph &) = delete;
+        TaskGraph &operator=(const TaskGraph &) = delete;
+
+        // 引用外部矩阵, 不复制; 在 run 结束前须保持有效且不被修改
+        Node input(const Matrix<T> &matrix) {
+            if (matrix.empty())
+                throw std::invalid_argument("Matrices must not be empty.");
+            NodeData node{matrix.rows(), matrix.cols()};
+            node.source = &matrix;
+            return add(std::move(node));
+        }
+
+        Node transpose(Node a) {
+            NodeData node{cols(a), rows(a)};
+            node.inputs = {{a.id, Need::All}};
+            node.tile = [this, a](std::size_t r0, std::size_t r1, MatrixView<T> out) {
+                MatrixView<const T, Layout::ColMajor> t = algebra::transpose(value(a.id));
+                detail::copy_blocked(t.block(r0, 0, r1 - r0, t.cols()), out);
+            };
+            return add(std::move(node));
+        }
+
+        // 输出的每个行块只需要 a 的同一行块和整个 b
+        Node multiply(Node a, Node b) {
+            if (cols(a) != rows(b))
+                throw std::invalid_argument("Matrix dimension mismatch.");
+            NodeData node{rows(a), cols(b)};
+            node.inputs = {{a.id, Need::Rows}, {b.id, Need::All}};
+            node.tile = [this, a, b](std::size_t r0, std::size_t r1, MatrixView<T> out) {
+                MatrixView<const T> x = value(a.id);
+                detail::gemm_kernel(T{1}, x.block(r0, 0, r1 - r0, x.cols()), value(b.id), T{0}, out);
+            };
+            return add(std::move(node));
+        }
+
+        Node multiply(Node a, const T scalar) {
+            NodeData node{rows(a), cols(a)};
+            node.inputs = {{a.id, Need::Rows}};
+            node.tile = [this, a, scalar](std::size_t r0, std::size_t r1, MatrixView<T> out) {
+                MatrixView<const T> x = value(a.id);
+                for (std::size_t i = r0; i < r1; ++i)
+                    for (std::size_t j = 0; j < out.cols(); ++j)
+                        out(i - r0, j) = x(i, j) * scalar;
+            };
+            return add(std::move(node));
+        }
+
+        Node sum_sub(Node a, Node b, std::optional<std::string> operation = "sum") {
+            if (operation.value() == "sub")
+                return elementwise<ElementOp::Sub>(a, b);
+            return elementwise<ElementOp::Sum>(a, b);
+        }
+
+        Node hadamard_product(Node a, Node b) {
+            return elementwise<ElementOp::Product>(a, b);
+        }
+
+        // 需要整个输入, 作为单个任务执行 (内部的 LU 分解自行并行)
+        Node inverse(Node a) {
+            if (rows(a) != cols(a))
+                throw std::invalid_argument("Matrix must be square.");
+            return apply({a}, rows(a), cols(a), [](const std::vector<MatrixView<const T>> &in) {
+                return LU<T>(in[0]).inverse();
+            });
+        }
+
+        // 自定义节点: 所有输入完成后调用 fn(输入视图), 返回 rows x cols 的结果
+        Node apply(const std::vector<Node> &inputs, std::size_t rows, std::size_t cols,
+                   std::function<Matrix<T>(const std::vector<MatrixView<const T>> &)> fn) {
+            if (rows == 0 || cols == 0)
+                throw std::invalid_argument("Matrices must not be empty.");
+            NodeData node{rows, cols};
+            for (Node in: inputs)
+                node.inputs.push_back({check(in).id, Need::All});
+            node.whole = [this, inputs, fn = std::move(fn)] {
+                std::vector<MatrixView<const T>> views;
+                for (Node in: inputs)
+                    views.push_back(value(in.id));
+                return fn(views);
+            };
+            return add(std::move(node));
+        }
+
+        // 保留该节点的结果, 即使它被其他节点使用
+        void keep(Node n) {
+            nodes[check(n).id].keep = true;
+        }
+
+        std::size_t rows(Node n) const { return nodes[check(n).id].rows; }
+        std::size_t cols(Node n) const { return nodes[check(n).id].cols; }
+
+        // 执行整个图, 调用线程也参与计算; 任何任务抛出的第一个异常在此重新抛出.
+        // 可以重复调用 (例如输入矩阵的内容改变之后), 上一次的结果会被回收
+        void run() {
+            std::size_t count = nodes.size();
+            for (auto &m: results)
+                buffers.release(std::exchange(m, Matrix<T>{}));
+            results.assign(count, Matrix<T>{});
+            outputs.assign(count, MatrixView<T>{});
+            progress.clear();
+            error = nullptr;
+            failed = false;
+
+            std::size_t computed = 0;
+            for (std::size_t id = 0; id < count; ++id) {
+                progress.push_back(std::make_unique<Progress>());
+                if (nodes[id].source)
+                    continue;
+                ++computed;
+                Progress &p = *progress[id];
+                p.tiles = tiles(id);
+                p.tiles_left = p.tiles;
+                p.waiting = std::vector<std::atomic<std::size_t>>(p.tiles);
+                std::size_t need = 0;
+                for (const Input &in: nodes[id].inputs)
+                    need += nodes[in.node].source ? 0 : 1;
+                for (auto &w: p.waiting)
+                    w = need;
+            }
+            for (std::size_t id = 0; id < count; ++id)
+                for (const Input &in: nodes[id].inputs)
+                    ++progress[in.node]->consumers_left;
+            remaining = computed;
+
+            // 先找出全部可以立即开始的行块再提交: 已提交的任务会减少其他行块的计数, 边检查边提交会重复调度
+            std::vector<std::pair<std::size_t, std::size_t>> ready;
+            for (std::size_t id = 0; id < count; ++id)
+                if (!nodes[id].source)
+                    for (std::size_t t = 0; t < progress[id]->tiles; ++t)
+                        if (progress[id]->waiting[t] == 0)
+                            ready.emplace_back(id, t);
+            for (auto [id, t]: ready)
+                schedule(id, t);
+
+            pool.help_until([this] { return remaining.load() == 0; });
+
+            if (error)
+                std::rethrow_exception(error);
+        }
+
+        // 节点的结果; 已被回收的中间结果或尚未计算时抛出异常
+        const Matrix<T> &result(Node n) const {
+            const NodeData &node = nodes[check(n).id];
+            if (node.source)
+                return *node.source;
+            if (n.id >= results.size() || results[n.id].empty())
+                throw std::invalid_argument("Node result is not available.");
+            return results[n.id];
+        }
+
+        // 到目前为止为中间结果分配的缓冲区个数 (复用的缓冲区不计入)
+        std::size_t allocations() const { return buffers.allocations(); }
+
+    private:
+        // Rows: 输出的第 t 个行块只需要输入的第 t 个行块; All: 需要整个输入
+        enum class Need { Rows,
+                          All };
+
+        struct Input {
+            std::size_t node;
+            Need need;
+        };
+
+        struct NodeData {
+            std::size_t rows, cols;
+            std::vector<Input> inputs{};
+            std::vector<Input> consumers{};// 使用该节点的节点与依赖方式
+            const Matrix<T> *source = nullptr;
+            bool keep = false;
+            // 分块节点计算输出的 [r0, r1) 行; 整体节点 (whole 非空) 作为一个任务计算整个结果
+            std::function<void(std::size_t, std::size_t, MatrixView<T>)> tile{};
+            std::function<Matrix<T>()> whole{};
+        };
+
+        // 一次 run 中各节点的进度
+        struct Progress {
+            std::size_t tiles{};
+            std::vector<std::atomic<std::size_t>> waiting;// 每个行块尚未就绪的输入数
+            std::atomic<std::size_t> tiles_left{0};
+            std::atomic<std::size_t> consumers_left{0};
+            std::once_flag allocated;
+        };
+
+        template<ElementOp Op>
+        Node elementwise(Node a, Node b) {
+            if (rows(a) != rows(b) || cols(a) != cols(b))
+                throw std::invalid_argument("Matrix dimension mismatch.");
+            NodeData node{rows(a), cols(a)};
+            node.inputs = {{a.id, Need::Rows}, {b.id, Need::Rows}};
+            node.tile = [this, a, b](std::size_t r0, std::size_t r1, MatrixView<T> out) {
+                MatrixView<const T> x = value(a.id), y = value(b.id);
+                unchecked::elementwise<Op>(x.block(r0, 0, r1 - r0, x.cols()), y.block(r0, 0, r1 - r0, y.cols()), out);
+            };
+            return add(std::move(node));
+        }
+
+        Node check(Node n) const {
+            if (n.id >= nodes.size())
+                throw std::invalid_argument("Node does not belong to this graph.");
+            return n;
+        }
+
+        Node add(NodeData node) {
+            std::size_t id = nodes.size();
+            for (Input &in: node.inputs) {
+                // 整体节点只有一个任务, 没有行块可以依赖
+                if (nodes[in.node].whole)
+                    in.need = Need::All;
+                nodes[in.node].consumers.push_back({id, in.need});
+            }
+            nodes.push_back(std::move(node));
+            return Node{id};
+        }
+
+        std::size_t tiles(std::size_t id) const {
+            const NodeData &node = nodes[id];
+            return node.whole ? 1 : (node.rows + tile_rows - 1) / tile_rows;
+        }
+
+        MatrixView<const T> value(std::size_t id) const {
+            return nodes[id].source ? nodes[id].source->view() : results[id].view();
+        }
+
+        void schedule(std::size_t id, std::size_t t) {
+            pool.submit([this, id, t] { run_tile(id, t); });
+        }
+
+        void run_tile(std::size_t id, std::size_t t) {
+            const NodeData &node = nodes[id];
+            if (!failed.load()) {
+                try {
+                    if (node.whole) {
+                        Matrix<T> res = node.whole();
+                        if (res.rows() != node.rows || res.cols() != node.cols)
+                            throw std::invalid_argument("Matrix dimension mismatch.");
+                        results[id] = std::move(res);
+                    } else {
+                        // 第一个开始的行块为整个节点取得缓冲区
+                        std::call_once(progress[id]->allocated, [&] {
+                            results[id] = buffers.acquire(node.rows, node.cols);
+                            outputs[id] = results[id].view();
+                        });
+                        std::size_t r0 = t * tile_rows, r1 = std::min(r0 + tile_rows, node.rows);
+                        node.tile(r0, r1, outputs[id].block(r0, 0, r1 - r0, node.cols));
+                    }
+                } catch (...) {
+                    std::lock_guard lock{mutex};
+                    if (!error)
+                        error = std::current_exception();
+                    failed = true;
+                }
+            }
+
+            // 失败后仍然推进计数, 使 run 能够结束
+            for (const Input &c: node.consumers)
+                if (c.need == Need::Rows && --progress[c.node]->waiting[t] == 0)
+                    schedule(c.node, t);
+            if (--progress[id]->tiles_left == 0)
+                finish(id);
+        }
+
+        void finish(std::size_t id) {
+            const NodeData &node = nodes[id];
+            // 先回收输入, 之后就绪的节点可以复用这些缓冲区
+            for (const Input &in: node.inputs) {
+                const NodeData &src = nodes[in.node];
+                if (!src.source && --progress[in.node]->consumers_left == 0 && !src.keep)
+                    buffers.release(std::exchange(results[in.node], Matrix<T>{}));
+            }
+            for (const Input &c: node.consumers)
+                if (c.need == Need::All)
+                    for (std::size_t t = 0; t < progress[c.node]->tiles; ++t)
+                        if (--progress[c.node]->waiting[t] == 0)
+                            schedule(c.node, t);
+            // 计数归零后 run 可能立即返回并析构本对象, 之后不能再访问成员
+            ThreadPool &executor = pool;
+            if (--remaining == 0)
+                executor.notify();
+        }
+
+        std::size_t tile_rows;
+        ThreadPool &pool;
+        std::vector<NodeData> nodes;
+
+        std::vector<Matrix<T>> results;
+        std::vector<MatrixView<T>> outputs;
+        std::vector<std::unique_ptr<Progress>> progress;
+        detail::BufferPool<T> buffers;
+        std::atomic<std::size_t> remaining{0};
+        std::atomic<bool> failed{false};
+        std::mutex mutex;
+        std::exception_ptr error;
+    };
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_TASK_GRAPH
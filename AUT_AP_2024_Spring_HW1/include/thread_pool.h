@@ -0,0 +1,225 @@
+#ifndef AUT_AP_2024_Spring_HW1_THREAD_POOL
+#define AUT_AP_2024_Spring_HW1_THREAD_POOL
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace algebra {
+
+    // 固定大小的工作窃取线程池, 调用 parallel_for 的线程本身也参与计算.
+    // 每个工作线程有自己的双端队列: 工作线程提交的任务进入自己的队列尾部并从尾部取出 (后进先出, 数据仍在缓存中),
+    // 空闲的线程从其他队列的头部窃取; 其他线程提交的任务进入共享队列.
+    class ThreadPool {
+    public:
+        // concurrency 为并行度 (含调用线程), 因此只创建 concurrency - 1 个工作线程
+        explicit ThreadPool(std::size_t concurrency)
+            : queues(std::max<std::size_t>(concurrency, 1)) {
+            for (std::size_t i = 1; i < queues.size(); ++i)
+                workers.emplace_back([this, i] { work(i); });
+        }
+
+        ~ThreadPool() {
+            {
+                std::lock_guard lock{mutex};
+                stopping = true;
+            }
+            ready.notify_all();
+            for (auto &worker: workers)
+                worker.join();
+        }
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        // 全局线程池, 并行度取环境变量 ALGEBRA_NUM_THREADS, 否则取硬件线程数
+        static ThreadPool &instance() {
+            static ThreadPool pool{default_concurrency()};
+            return pool;
+        }
+
+        static std::size_t default_concurrency() {
+            if (const char *env = std::getenv("ALGEBRA_NUM_THREADS"))
+                if (long n = std::strtol(env, nullptr, 10); n > 0)
+                    return static_cast<std::size_t>(n);
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        std::size_t concurrency() const { return workers.size() + 1; }
+
+        // 提交一个独立任务, 不等待其完成
+        void submit(std::function<void()> task) {
+            {
+                std::lock_guard lock{mutex};
+                ++pending;
+            }
+            Queue &queue = queues[own_queue()];
+            {
+                std::lock_guard lock{queue.mutex};
+                queue.tasks.push_back(std::move(task));
+            }
+            ready.notify_one();
+        }
+
+        // 在当前线程执行池中的任务, 直到 done() 为真. 等待其他任务的结果 (如任务图) 时
+        // 不占住线程, 在工作线程中调用也不会死锁. 使 done() 变为真的一方需要随后调用 notify()
+        template<typename F>
+        void help_until(F &&done) {
+            std::size_t self = own_queue();
+            while (!done()) {
+                if (std::function<void()> task = take(self)) {
+                    task();
+                    continue;
+                }
+                std::unique_lock lock{mutex};
+                ready.wait(lock, [&] { return pending > 0 || done(); });
+            }
+        }
+
+        // 唤醒在 help_until 中等待的线程
+        void notify() {
+            { std::lock_guard lock{mutex}; }
+            ready.notify_all();
+        }
+
+        // 把 [begin, end) 按 grain 切成固定的块, 并行调用 fn(lo, hi).
+        // 块的划分只取决于 grain, 与线程数无关; 任何块抛出的第一个异常会在调用线程重新抛出.
+        template<typename F>
+        void parallel_for(std::size_t begin, std::size_t end, std::size_t grain, F &&fn) {
+            if (begin >= end)
+                return;
+
+            grain = std::max<std::size_t>(grain, 1);
+            std::size_t chunks = (end - begin + grain - 1) / grain;
+
+            auto run = [&](std::size_t chunk) {
+                std::size_t lo = begin + chunk * grain;
+                fn(lo, std::min(lo + grain, end));
+            };
+
+            if (chunks == 1 || workers.empty()) {
+                for (std::size_t c = 0; c < chunks; ++c)
+                    run(c);
+                return;
+            }
+
+            struct State {
+                std::atomic<std::size_t> next{0}, done{0};
+                std::mutex mutex;
+                std::condition_variable finished;
+                std::exception_ptr error;
+            };
+
+            auto state = std::make_shared<State>();
+            std::function<void(std::size_t)> body = run;
+
+            // 工作线程可能在所有块完成之后才开始执行, 此时不会再访问 body
+            auto drain = [state, chunks, body = &body] {
+                for (std::size_t c; (c = state->next.fetch_add(1)) < chunks;) {
+                    try {
+                        (*body)(c);
+                    } catch (...) {
+                        std::lock_guard lock{state->mutex};
+                        if (!state->error)
+                            state->error = std::current_exception();
+                    }
+                    if (state->done.fetch_add(1) + 1 == chunks) {
+                        std::lock_guard lock{state->mutex};
+                        state->finished.notify_all();
+                    }
+                }
+            };
+
+            std::size_t helpers = std::min(chunks - 1, workers.size());
+            for (std::size_t h = 0; h < helpers; ++h)
+                submit(drain);
+
+            drain();
+
+            std::unique_lock lock{state->mutex};
+            state->finished.wait(lock, [&] { return state->done.load() == chunks; });
+
+            if (state->error)
+                std::rethrow_exception(state->error);
+        }
+
+    private:
+        struct Queue {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        // 当前线程提交任务使用的队列: 本池的工作线程用自己的队列, 其他线程用共享队列 0
+        std::size_t own_queue() const {
+            auto [pool, index] = current();
+            return pool == this ? index : 0;
+        }
+
+        static std::pair<const ThreadPool *, std::size_t> &current() {
+            thread_local std::pair<const ThreadPool *, std::size_t> owner{nullptr, 0};
+            return owner;
+        }
+
+        // 依次尝试: 自己队列的尾部, 共享队列的头部, 其他工作线程队列的头部
+        std::function<void()> take(std::size_t self) {
+            std::function<void()> task;
+            auto pop = [&](std::size_t q, bool back) {
+                std::lock_guard lock{queues[q].mutex};
+                auto &tasks = queues[q].tasks;
+                if (tasks.empty())
+                    return false;
+                if (back) {
+                    task = std::move(tasks.back());
+                    tasks.pop_back();
+                } else {
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                }
+                return true;
+            };
+
+            bool found = (self != 0 && pop(self, true)) || pop(0, false);
+            for (std::size_t i = 1; !found && i < queues.size(); ++i)
+                found = (self + i) % queues.size() != 0 && pop((self + i) % queues.size(), false);
+            if (found) {
+                std::lock_guard lock{mutex};
+                --pending;
+            }
+            return task;
+        }
+
+        void work(std::size_t self) {
+            current() = {this, self};
+            for (;;) {
+                if (std::function<void()> task = take(self)) {
+                    task();
+                    continue;
+                }
+                std::unique_lock lock{mutex};
+                ready.wait(lock, [this] { return stopping || pending > 0; });
+                if (stopping && pending == 0)
+                    return;
+            }
+        }
+
+        std::vector<Queue> queues;
+        std::vector<std::thread> workers;
+        std::size_t pending{0};// 所有队列中的任务数, 由 mutex 保护
+        std::mutex mutex;
+        std::condition_variable ready;
+        bool stopping{false};
+    };
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_THREAD_POOL
@@ -0,0 +1,135 @@
+#ifndef AUT_AP_2024_Spring_HW1_TUNER
+#define AUT_AP_2024_Spring_HW1_TUNER
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <ostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "kernel.h"
+#include "lu.h"
+#include "matrix.h"
+#include "thread_pool.h"
+#include "tuning.h"
+
+namespace algebra {
+
+    struct TuneOptions {
+        std::size_t size = 512;        // 分块参数与 LU 使用的矩阵阶数
+        std::size_t repeats = 3;       // 每个候选取最短的一次
+        std::ostream *log = nullptr;   // 非空时输出每个候选的耗时
+    };
+
+    namespace detail {
+
+        inline Matrix<double> tuning_matrix(std::size_t rows, std::size_t cols, unsigned seed) {
+            std::mt19937 gen(seed);
+            std::uniform_real_distribution<double> dist(-1, 1);
+            Matrix<double> res(rows, cols);
+            double *data = res.data();
+            for (std::size_t x = 0; x < res.size(); ++x)
+                data[x] = dist(gen);
+            // 对角占优, 使 LU 不需要大量换行
+            for (std::size_t i = 0; i < std::min(rows, cols); ++i)
+                data[i * cols + i] += static_cast<double>(cols);
+            return res;
+        }
+
+        inline double best_time(std::size_t repeats, const std::function<void()> &fn) {
+            fn();// 预热: 分配线程局部缓冲区, 填充缓存
+            double best = std::numeric_limits<double>::infinity();
+            for (std::size_t r = 0; r < repeats; ++r) {
+                auto start = std::chrono::steady_clock::now();
+                fn();
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                best = std::min(best, elapsed.count());
+            }
+            return best;
+        }
+
+        // 逐个参数做坐标搜索: 其余参数固定为当前最优值, 选出使 workload 最快的候选
+        inline void tune_field(TuningConfig &best, std::size_t TuningConfig::*field, const char *name,
+                               const std::vector<std::size_t> &candidates, const TuneOptions &opts,
+                               const std::function<void()> &workload) {
+            double best_seconds = std::numeric_limits<double>::infinity();
+            std::size_t winner = best.*field;
+            for (std::size_t c: candidates) {
+                TuningConfig trial = best;
+                trial.*field = c;
+                set_tuning(trial);
+                double seconds = best_time(opts.repeats, workload);
+                if (opts.log)
+                    *opts.log << name << " = " << c << ": " << seconds * 1e3 << " ms\n";
+                if (seconds < best_seconds) {
+                    best_seconds = seconds;
+                    winner = c;
+                }
+            }
+            best.*field = winner;
+            set_tuning(best);
+        }
+
+    }// namespace detail
+
+    // 在当前主机上校准分块参数: GEMM 的块大小, 微内核展开行数, 打包与并行的阈值, 转置块大小和 LU 面板宽度.
+    // 从当前参数出发逐个搜索, 结束时结果已生效 (set_tuning), 需要持久化时再调用 save_tuning.
+    inline TuningConfig autotune(const TuneOptions &opts = {}) {
+        using detail::tuning_matrix;
+        std::size_t n = std::max<std::size_t>(opts.size, 64);
+        Matrix<double> a = tuning_matrix(n, n, 1), b = tuning_matrix(n, n, 2), c(n, n);
+        TuningConfig best = tuning();
+
+        auto gemm = [&] { detail::gemm_kernel(1.0, std::as_const(a).view(), std::as_const(b).view(), 0.0, c.view()); };
+        detail::tune_field(best, &TuningConfig::gemm_unroll, "gemm_unroll", {1, 2, 4}, opts, gemm);
+        detail::tune_field(best, &TuningConfig::gemm_block_k, "gemm_block_k", {64, 128, 256, 512}, opts, gemm);
+        detail::tune_field(best, &TuningConfig::gemm_block_n, "gemm_block_n", {64, 128, 256, 512}, opts, gemm);
+        detail::tune_field(best, &TuningConfig::gemm_block_m, "gemm_block_m", {16, 32, 64, 128}, opts, gemm);
+
+        // 阈值附近的一组小矩阵乘法
+        auto sweep = [](std::size_t lo, std::size_t hi, std::size_t step) {
+            std::vector<Matrix<double>> ms;
+            for (std::size_t s = lo; s <= hi; s += step)
+                ms.push_back(tuning_matrix(s, s, static_cast<unsigned>(s)));
+            return ms;
+        };
+        auto multiply_all = [](const std::vector<Matrix<double>> &ms, std::size_t times) {
+            return [&ms, times] {
+                for (const auto &m: ms) {
+                    Matrix<double> out(m.rows(), m.cols());
+                    for (std::size_t t = 0; t < times; ++t)
+                        detail::gemm_kernel(1.0, m.view(), m.view(), 0.0, out.view());
+                }
+            };
+        };
+
+        auto small = sweep(16, 64, 8);
+        detail::tune_field(best, &TuningConfig::small_gemm, "small_gemm",
+                           {16 * 16 * 16, 24 * 24 * 24, 32 * 32 * 32, 48 * 48 * 48, 64 * 64 * 64}, opts, multiply_all(small, 20));
+
+        if (ThreadPool::instance().concurrency() > 1) {
+            auto medium = sweep(64, 256, 32);
+            detail::tune_field(best, &TuningConfig::parallel_gemm, "parallel_gemm",
+                               {64 * 64 * 64, 96 * 96 * 96, 128 * 128 * 128, 192 * 192 * 192, 256 * 256 * 256}, opts,
+                               multiply_all(medium, 1));
+        }
+
+        std::size_t t = 2 * n;
+        Matrix<double> src = tuning_matrix(t, t, 3);
+        Matrix<double, Layout::ColMajor> dst(t, t);
+        detail::tune_field(best, &TuningConfig::transpose_block, "transpose_block", {8, 16, 32, 64, 128}, opts,
+                           [&] { detail::copy_blocked(std::as_const(src).view(), dst.view()); });
+
+        detail::tune_field(best, &TuningConfig::lu_panel, "lu_panel", {16, 32, 64, 128}, opts,
+                           [&] { LU<double> lu(a); });
+
+        return best;
+    }
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_TUNER
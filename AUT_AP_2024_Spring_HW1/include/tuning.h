@@ -0,0 +1,201 @@
+#ifndef AUT_AP_2024_Spring_HW1_TUNING
+#define AUT_AP_2024_Spring_HW1_TUNING
+
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace algebra {
+
+    // 与主机相关的分块参数. 默认值适合常见的 x86 服务器;
+    // 可以用 autotune (tuner.h) 按 CPU 型号校准, 结果缓存在配置文件中, 第一次使用时自动加载.
+    struct TuningConfig {
+        std::size_t gemm_block_m = 64;              // 打包 A 块的行数
+        std::size_t gemm_block_k = 256;             // 打包块在内积维度上的长度
+        std::size_t gemm_block_n = 256;             // 打包 B 块的列数
+        std::size_t gemm_unroll = 4;                // 微内核同时处理的 A 行数 (1, 2 或 4)
+        std::size_t small_gemm = 32 * 32 * 32;      // m * n * k 不超过该值时直接循环, 不做打包
+        std::size_t parallel_gemm = 128 * 128 * 128;// m * n * k 达到该值时才把输出块分给多个线程
+        std::size_t transpose_block = 32;           // 分块转置复制的块大小
+        std::size_t lu_panel = 64;                  // 分块 LU 的面板宽度
+
+        bool operator==(const TuningConfig &) const = default;
+    };
+
+    namespace detail {
+
+        // 配置文件中的字段名
+        inline constexpr std::pair<const char *, std::size_t TuningConfig::*> kTuningFields[] = {
+                {"gemm_block_m", &TuningConfig::gemm_block_m},
+                {"gemm_block_k", &TuningConfig::gemm_block_k},
+                {"gemm_block_n", &TuningConfig::gemm_block_n},
+                {"gemm_unroll", &TuningConfig::gemm_unroll},
+                {"small_gemm", &TuningConfig::small_gemm},
+                {"parallel_gemm", &TuningConfig::parallel_gemm},
+                {"transpose_block", &TuningConfig::transpose_block},
+                {"lu_panel", &TuningConfig::lu_panel},
+        };
+
+        // 把参数限制在内核可以处理的范围内
+        inline TuningConfig sanitize(TuningConfig config) {
+            for (auto [name, field]: kTuningFields)
+                if (config.*field == 0)
+                    config.*field = 1;
+            config.gemm_unroll = config.gemm_unroll >= 4 ? 4 : config.gemm_unroll >= 2 ? 2 : 1;
+            return config;
+        }
+
+        inline std::string_view trim(std::string_view s) {
+            while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+                s.remove_prefix(1);
+            while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r'))
+                s.remove_suffix(1);
+            return s;
+        }
+
+        // 依次对每一行调用 fn(line)
+        template<typename F>
+        void for_each_config_line(std::string_view text, F &&fn) {
+            while (!text.empty()) {
+                std::size_t nl = text.find('\n');
+                fn(trim(text.substr(0, nl)));
+                text = nl == std::string_view::npos ? std::string_view{} : text.substr(nl + 1);
+            }
+        }
+
+    }// namespace detail
+
+    // 当前主机的 CPU 型号, 作为配置文件中的节名; 无法识别时为 "unknown"
+    inline std::string cpu_model() {
+        std::ifstream in("/proc/cpuinfo");
+        for (std::string line; std::getline(in, line);) {
+            if (line.starts_with("model name")) {
+                if (std::size_t colon = line.find(':'); colon != std::string::npos)
+                    return std::string(detail::trim(std::string_view(line).substr(colon + 1)));
+            }
+        }
+        return "unknown";
+    }
+
+    // 配置文件路径: 环境变量 ALGEBRA_TUNING_FILE, 否则为 $XDG_CONFIG_HOME/algebra/tuning.conf
+    // 或 $HOME/.config/algebra/tuning.conf; 都不可用时为空
+    inline std::filesystem::path tuning_path() {
+        if (const char *file = std::getenv("ALGEBRA_TUNING_FILE"))
+            return file;
+        if (const char *xdg = std::getenv("XDG_CONFIG_HOME"); xdg && *xdg)
+            return std::filesystem::path(xdg) / "algebra" / "tuning.conf";
+        if (const char *home = std::getenv("HOME"); home && *home)
+            return std::filesystem::path(home) / ".config" / "algebra" / "tuning.conf";
+        return {};
+    }
+
+    // 从配置文本中读取 [model] 一节; 未列出的字段保持默认值, 没有该节时返回空.
+    // 格式:
+    //   [Intel(R) Xeon(R) Gold 6248 CPU @ 2.50GHz]
+    //   gemm_block_m = 64
+    //   ...
+    inline std::optional<TuningConfig> parse_tuning(std::string_view text, std::string_view model) {
+        std::optional<TuningConfig> res;
+        bool in_section = false;
+        detail::for_each_config_line(text, [&](std::string_view line) {
+            if (line.empty() || line.front() == '#')
+                return;
+            if (line.front() == '[' && line.back() == ']') {
+                in_section = detail::trim(line.substr(1, line.size() - 2)) == model;
+                if (in_section && !res)
+                    res.emplace();
+                return;
+            }
+            std::size_t eq = line.find('=');
+            if (!in_section || eq == std::string_view::npos)
+                return;
+            std::string_view key = detail::trim(line.substr(0, eq));
+            std::string value(detail::trim(line.substr(eq + 1)));
+            for (auto [name, field]: detail::kTuningFields)
+                if (key == name)
+                    (*res).*field = std::strtoull(value.c_str(), nullptr, 10);
+        });
+        if (res)
+            res = detail::sanitize(*res);
+        return res;
+    }
+
+    // 用 config 替换 text 中的 [model] 一节 (不存在时追加), 其余内容保持不变
+    inline std::string format_tuning(std::string_view text, std::string_view model, const TuningConfig &config) {
+        std::ostringstream out;
+        bool in_section = false;
+        detail::for_each_config_line(text, [&](std::string_view line) {
+            if (!line.empty() && line.front() == '[' && line.back() == ']')
+                in_section = detail::trim(line.substr(1, line.size() - 2)) == model;
+            if (!in_section && !line.empty())
+                out << line << '\n';
+        });
+        out << '[' << model << "]\n";
+        for (auto [name, field]: detail::kTuningFields)
+            out << name << " = " << config.*field << '\n';
+        return std::move(out).str();
+    }
+
+    inline std::optional<TuningConfig> load_tuning(const std::filesystem::path &path = tuning_path(),
+                                                   const std::string &model = cpu_model()) {
+        if (path.empty())
+            return std::nullopt;
+        std::ifstream in(path);
+        if (!in)
+            return std::nullopt;
+        std::ostringstream text;
+        text << in.rdbuf();
+        return parse_tuning(text.view(), model);
+    }
+
+    // 写入 (或更新) 配置文件中当前 CPU 型号的一节
+    inline void save_tuning(const TuningConfig &config, const std::filesystem::path &path = tuning_path(),
+                            const std::string &model = cpu_model()) {
+        if (path.empty())
+            throw std::runtime_error("No path for the tuning file.");
+
+        std::string existing;
+        if (std::ifstream in(path); in) {
+            std::ostringstream text;
+            text << in.rdbuf();
+            existing = std::move(text).str();
+        }
+
+        std::error_code ec;
+        if (path.has_parent_path())
+            std::filesystem::create_directories(path.parent_path(), ec);
+        std::ofstream out(path, std::ios::trunc);
+        out << format_tuning(existing, model, config);
+        if (!out)
+            throw std::runtime_error("Cannot write tuning file: " + path.string());
+    }
+
+    namespace detail {
+
+        inline TuningConfig &tuning_state() {
+            static TuningConfig config = load_tuning().value_or(TuningConfig{});
+            return config;
+        }
+
+    }// namespace detail
+
+    // 当前生效的参数: 第一次调用时从配置文件加载当前 CPU 型号的一节, 没有时使用默认值
+    inline const TuningConfig &tuning() {
+        return detail::tuning_state();
+    }
+
+    // 替换当前参数; 不要与正在进行的运算并发调用
+    inline void set_tuning(const TuningConfig &config) {
+        detail::tuning_state() = detail::sanitize(config);
+    }
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_TUNING
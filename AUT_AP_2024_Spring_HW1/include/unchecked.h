@@ -0,0 +1,160 @@
+#ifndef AUT_AP_2024_Spring_HW1_UNCHECKED
+#define AUT_AP_2024_Spring_HW1_UNCHECKED
+
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+#include "algebra.h"
+#include "kernel.h"
+#include "matrix.h"
+
+namespace algebra {
+
+    // 逐元素运算的种类, 在编译期分派 (取代 sum_sub 的字符串参数)
+    enum class ElementOp { Sum,
+                           Sub,
+                           Product };
+
+    namespace detail {
+
+        template<ElementOp Op, typename T>
+        constexpr T apply(const T &a, const T &b) noexcept {
+            if constexpr (Op == ElementOp::Sum)
+                return a + b;
+            else if constexpr (Op == ElementOp::Sub)
+                return a - b;
+            else
+                return a * b;
+        }
+
+    }// namespace detail
+
+    // 不做运行期检查的快速版本: 调用者保证维度匹配且矩阵非空.
+    // 前置条件只在调试构建 (未定义 NDEBUG) 中由 assert 检查, 违反时行为未定义.
+    // 全部函数为 noexcept; 需要分配结果的函数在内存不足时调用 std::terminate.
+    namespace unchecked {
+
+        // out = a op b, 三者可为不同存储顺序; out 可以与 a 或 b 是同一块存储
+        template<ElementOp Op, typename TA, Layout LA, typename TB, Layout LB, typename T, Layout LC>
+            requires std::is_same_v<std::remove_const_t<TA>, T> && std::is_same_v<std::remove_const_t<TB>, T>
+        void elementwise(MatrixView<TA, LA> a, MatrixView<TB, LB> b, MatrixView<T, LC> out) noexcept {
+            assert(a.rows() == b.rows() && a.cols() == b.cols());
+            assert(a.rows() == out.rows() && a.cols() == out.cols());
+
+            std::size_t lines = LC == Layout::RowMajor ? out.rows() : out.cols();
+            std::size_t len = LC == Layout::RowMajor ? out.cols() : out.rows();
+
+            if constexpr (LA == LC && LB == LC) {
+                if (a.contiguous() && b.contiguous() && out.contiguous()) {
+                    len *= lines;
+                    lines = 1;
+                }
+                for (std::size_t l = 0; l < lines; ++l) {
+                    const T *x = a.data() + l * a.ld(), *y = b.data() + l * b.ld();
+                    T *z = out.data() + l * out.ld();
+                    for (std::size_t p = 0; p < len; ++p)
+                        z[p] = detail::apply<Op>(x[p], y[p]);
+                }
+            } else {
+                for (std::size_t l = 0; l < lines; ++l)
+                    for (std::size_t p = 0; p < len; ++p) {
+                        std::size_t i = LC == Layout::RowMajor ? l : p;
+                        std::size_t j = LC == Layout::RowMajor ? p : l;
+                        out(i, j) = detail::apply<Op>(a(i, j), b(i, j));
+                    }
+            }
+        }
+
+        template<ElementOp Op = ElementOp::Sum, typename T, Layout LA, Layout LB>
+        Matrix<T, LA> sum_sub(Matrix<T, LA> matrixA, const Matrix<T, LB> &matrixB) noexcept {
+            static_assert(Op != ElementOp::Product, "Use hadamard_product for element-wise products.");
+            MatrixView<T, LA> res = matrixA.view();
+            elementwise<Op>(res, matrixB.view(), res);
+            return matrixA;
+        }
+
+        template<typename T, Layout LA, Layout LB>
+        Matrix<T, LA> hadamard_product(Matrix<T, LA> matrixA, const Matrix<T, LB> &matrixB) noexcept {
+            MatrixView<T, LA> res = matrixA.view();
+            elementwise<ElementOp::Product>(res, matrixB.view(), res);
+            return matrixA;
+        }
+
+        template<typename T, Layout L>
+        Matrix<T, L> multiply(Matrix<T, L> matrix, const T scalar) noexcept {
+            T *data = matrix.data();
+            for (std::size_t x = 0; x < matrix.size(); ++x)
+                data[x] *= scalar;
+            return matrix;
+        }
+
+        // C = alpha * A * B + beta * C
+        template<typename T, Layout LA, Layout LB, Layout LC>
+        void gemm(T alpha, MatrixView<const T, LA> A, MatrixView<const T, LB> B, T beta, MatrixView<T, LC> C) noexcept {
+            assert(A.cols() == B.rows() && A.rows() == C.rows() && B.cols() == C.cols());
+            detail::gemm_kernel(alpha, A, B, beta, C);
+        }
+
+        template<Layout LC = Layout::RowMajor, typename T, Layout LA, Layout LB>
+        Matrix<T, LC> multiply(const Matrix<T, LA> &matrixA, const Matrix<T, LB> &matrixB) noexcept {
+            Matrix<T, LC> res(matrixA.rows(), matrixB.cols());
+            gemm(T{1}, matrixA.view(), matrixB.view(), T{0}, res.view());
+            return res;
+        }
+
+        template<typename T, Layout L>
+        T trace(MatrixView<const T, L> matrix) noexcept {
+            assert(matrix.rows() == matrix.cols());
+            T res{};
+            for (std::size_t i = 0; i < matrix.rows(); ++i)
+                res += matrix(i, i);
+            return res;
+        }
+
+        template<typename T, Layout L>
+        T trace(const Matrix<T, L> &matrix) noexcept {
+            return trace(matrix.view());
+        }
+
+        // 嵌套向量 MATRIX<T> 版本
+        template<ElementOp Op = ElementOp::Sum, typename T>
+        MATRIX<T> sum_sub(const MATRIX<T> &matrixA, const MATRIX<T> &matrixB) noexcept {
+            static_assert(Op != ElementOp::Product, "Use hadamard_product for element-wise products.");
+            assert(matrixA.size() == matrixB.size());
+            MATRIX<T> res{matrixA};
+            for (std::size_t i = 0; i < res.size(); ++i) {
+                assert(res[i].size() == matrixB[i].size());
+                for (std::size_t j = 0; j < res[i].size(); ++j)
+                    res[i][j] = detail::apply<Op>(res[i][j], matrixB[i][j]);
+            }
+            return res;
+        }
+
+        template<typename T>
+        MATRIX<T> hadamard_product(const MATRIX<T> &matrixA, const MATRIX<T> &matrixB) noexcept {
+            assert(matrixA.size() == matrixB.size());
+            MATRIX<T> res{matrixA};
+            for (std::size_t i = 0; i < res.size(); ++i) {
+                assert(res[i].size() == matrixB[i].size());
+                for (std::size_t j = 0; j < res[i].size(); ++j)
+                    res[i][j] *= matrixB[i][j];
+            }
+            return res;
+        }
+
+        template<typename T>
+        T trace(const MATRIX<T> &matrix) noexcept {
+            T res{};
+            for (std::size_t i = 0; i < matrix.size(); ++i) {
+                assert(matrix[i].size() == matrix.size());
+                res += matrix[i][i];
+            }
+            return res;
+        }
+
+    }// namespace unchecked
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_UNCHECKED
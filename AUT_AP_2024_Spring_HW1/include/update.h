@@ -0,0 +1,189 @@
+#ifndef AUT_AP_2024_Spring_HW1_UPDATE
+#define AUT_AP_2024_Spring_HW1_UPDATE
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "blas.h"
+#include "kernel.h"
+#include "lu.h"
+#include "matrix.h"
+
+namespace algebra {
+
+    // 可更新的逆矩阵: 保存 A 与 A^{-1}, 通过 Sherman-Morrison-Woodbury 公式在 O(n^2) (秩 k 时 O(n^2 k))
+    // 内完成低秩更新、整行/整列替换, 并同步更新行列式. 每次更新都会累积舍入误差, 必要时调用 refresh().
+    template<typename T>
+    class UpdatableInverse {
+    public:
+        template<MatrixLike M>
+        explicit UpdatableInverse(const M &matrix) {
+            auto view = const_view(matrix);
+            a = Matrix<T>(view.rows(), view.cols());
+            detail::copy_blocked(view, a.view());
+            refresh();
+        }
+
+        std::size_t size() const { return a.rows(); }
+
+        // 当前的 A
+        const Matrix<T> &matrix() const { return a; }
+
+        // 当前的 A^{-1}
+        const Matrix<T> &inverse() const { return inv; }
+
+        LogDeterminant<T> slogdet() const { return logdet; }
+
+        T determinant() const { return static_cast<T>(logdet.sign) * std::exp(logdet.log_abs); }
+
+        // 自上次 refresh() 以来的更新次数
+        std::size_t updates() const { return count; }
+
+        // 由 A 重新做 LU 分解, 消除累积误差
+        void refresh() {
+            LU<T> lu(a);
+            if (lu.singular())
+                throw std::invalid_argument("Singular matrix.");
+            inv = lu.inverse();
+            logdet = lu.slogdet();
+            count = 0;
+        }
+
+        // x = A^{-1} * b
+        std::vector<T> solve(const std::vector<T> &rhs) const {
+            return gemv(inv, rhs);
+        }
+
+        // A = A + u * v^T
+        void rank_one_update(std::span<const T> u, std::span<const T> v) {
+            check_length(u);
+            check_length(v);
+            std::size_t n = size();
+
+            std::vector<T> bu(n), vtb(n);
+            detail::gemv_kernel(Op::NoTrans, T{1}, std::as_const(inv).view(), u.data(), T{0}, bu.data());
+            detail::gemv_kernel(Op::Trans, T{1}, std::as_const(inv).view(), v.data(), T{0}, vtb.data());
+            T denom = T{1} + detail::sum_lanes<T>(0, n, [&](std::size_t i) { return v[i] * bu[i]; });
+
+            apply_rank_one(bu, vtb, denom);
+            detail::ger_kernel(T{1}, u.data(), v.data(), a.view());
+        }
+
+        // A = A + U * V^T, U 与 V 均为 n x k
+        template<MatrixLike MU, MatrixLike MV>
+        void rank_update(const MU &matrixU, const MV &matrixV) {
+            auto U = const_view(matrixU);
+            auto V = const_view(matrixV);
+            static_assert(std::is_same_v<typename decltype(U)::value_type, T> &&
+                                  std::is_same_v<typename decltype(V)::value_type, T>,
+                          "Update factors must share the element type.");
+            if (U.rows() != size() || V.rows() != size() || U.cols() != V.cols())
+                throw std::invalid_argument("Matrix dimension mismatch.");
+
+            std::size_t n = size(), k = U.cols();
+            if (k == 0)
+                return;
+
+            // C = I + V^T * A^{-1} * U, A'^{-1} = A^{-1} - (A^{-1} U) C^{-1} (V^T A^{-1})
+            Matrix<T> bu(n, k), vtb(k, n), c(k, k);
+            detail::gemm_kernel(T{1}, std::as_const(inv).view(), U, T{0}, bu.view());
+            detail::gemm_kernel(T{1}, transpose(V), std::as_const(inv).view(), T{0}, vtb.view());
+            for (std::size_t i = 0; i < k; ++i)
+                c(i, i) = T{1};
+            detail::gemm_kernel(T{1}, transpose(V), std::as_const(bu).view(), T{1}, c.view());
+
+            // 与 apply_rank_one 相同的容差: C 的最小主元过小即视为奇异, 状态保持不变
+            LU<T> lu(c);
+            T min_pivot = std::numeric_limits<T>::infinity();
+            for (std::size_t i = 0; i < k; ++i)
+                min_pivot = std::min(min_pivot, std::abs(lu.factors()(i, i)));
+            if (lu.singular() || !(min_pivot > std::numeric_limits<T>::epsilon() * size()))
+                throw std::invalid_argument("Update makes the matrix singular.");
+            Matrix<T> x = lu.solve(vtb);
+
+            detail::gemm_kernel(T{-1}, std::as_const(bu).view(), std::as_const(x).view(), T{1}, inv.view());
+            detail::gemm_kernel(T{1}, U, transpose(V), T{1}, a.view());
+            update_determinant(lu.slogdet());
+        }
+
+        // 把第 i 行替换为 row: u = e_i, v = row - A(i, :)
+        void replace_row(std::size_t i, std::span<const T> row) {
+            check_index(i);
+            check_length(row);
+            std::size_t n = size();
+
+            std::vector<T> v(n), bu(n), vtb(n);
+            for (std::size_t j = 0; j < n; ++j) {
+                v[j] = row[j] - a(i, j);
+                bu[j] = inv(j, i);
+            }
+            detail::gemv_kernel(Op::Trans, T{1}, std::as_const(inv).view(), v.data(), T{0}, vtb.data());
+
+            apply_rank_one(bu, vtb, T{1} + vtb[i]);
+            std::copy(row.begin(), row.end(), a.data() + i * n);
+        }
+
+        // 把第 j 列替换为 col: u = col - A(:, j), v = e_j
+        void replace_column(std::size_t j, std::span<const T> col) {
+            check_index(j);
+            check_length(col);
+            std::size_t n = size();
+
+            std::vector<T> u(n), bu(n), vtb(n);
+            for (std::size_t i = 0; i < n; ++i) {
+                u[i] = col[i] - a(i, j);
+                vtb[i] = inv(j, i);
+            }
+            detail::gemv_kernel(Op::NoTrans, T{1}, std::as_const(inv).view(), u.data(), T{0}, bu.data());
+
+            apply_rank_one(bu, vtb, T{1} + bu[j]);
+            for (std::size_t i = 0; i < n; ++i)
+                a(i, j) = col[i];
+        }
+
+    private:
+        void check_length(std::span<const T> x) const {
+            if (x.size() != size())
+                throw std::invalid_argument("Matrix dimension mismatch.");
+        }
+
+        void check_index(std::size_t i) const {
+            if (i >= size())
+                throw std::out_of_range("Index out of range.");
+        }
+
+        // Sherman-Morrison: A'^{-1} = A^{-1} - (A^{-1} u)(v^T A^{-1}) / (1 + v^T A^{-1} u),
+        // det(A') = det(A) * (1 + v^T A^{-1} u). 分母过小时拒绝更新, 状态保持不变
+        void apply_rank_one(const std::vector<T> &bu, const std::vector<T> &vtb, T denom) {
+            if (!(std::abs(denom) > std::numeric_limits<T>::epsilon() * size()))
+                throw std::invalid_argument("Update makes the matrix singular.");
+
+            detail::ger_kernel(-T{1} / denom, bu.data(), vtb.data(), inv.view());
+            update_determinant({denom < T{0} ? -1 : 1, std::log(std::abs(denom))});
+        }
+
+        void update_determinant(LogDeterminant<T> factor) {
+            logdet.sign *= factor.sign;
+            logdet.log_abs += factor.log_abs;
+            ++count;
+        }
+
+        Matrix<T> a;
+        Matrix<T> inv;
+        LogDeterminant<T> logdet{};
+        std::size_t count{};
+    };
+
+    template<MatrixLike M>
+    UpdatableInverse(const M &) -> UpdatableInverse<typename decltype(const_view(std::declval<M>()))::value_type>;
+
+}// namespace algebra
+
+#endif// AUT_AP_2024_Spring_HW1_UPDATE
@@ -0,0 +1,228 @@
+#include "blas.h"
+#include "instrument.h"
+#include "kernel.h"
+#include "lu.h"
+#include "matrix.h"
+#include "perf_counters.h"
+#include "precision.h"
+#include "shm.h"
+#include "tuner.h"
+#include "tuning.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace algebra;
+
+namespace {
+
+	// --perf 时打开的硬件计数器, 以及最近一次 best_of 中平均每次运行的计数
+	PerfCounters *counters = nullptr;
+	PerfCounters::Sample last_sample;
+
+	// 运行 repeats 次, 返回最短耗时 (秒)
+	template<typename F>
+	double best_of(std::size_t repeats, F &&f) {
+		double best = std::numeric_limits<double>::infinity();
+		if (counters)
+			counters->start();
+		for (std::size_t r = 0; r < repeats; ++r) {
+			auto start = std::chrono::steady_clock::now();
+			f();
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			best = std::min(best, elapsed.count());
+		}
+		if (counters) {
+			last_sample = counters->stop();
+			for (auto &value: last_sample)
+				if (value)
+					*value /= static_cast<double>(repeats);
+		}
+		return best;
+	}
+
+	// 相对于 double 参考结果的最大相对误差
+	template<typename T>
+	double max_error(const Matrix<T> &value, const Matrix<double> &reference) {
+		double err = 0, scale = 0;
+		for (std::size_t i = 0; i < reference.rows(); ++i) {
+			for (std::size_t j = 0; j < reference.cols(); ++j) {
+				err = std::max(err, std::abs(static_cast<double>(value(i, j)) - reference(i, j)));
+				scale = std::max(scale, std::abs(reference(i, j)));
+			}
+		}
+		return err / scale;
+	}
+
+	// 计数器的比值, 缺少任一项时为 n/a
+	std::string ratio(const char *format, std::optional<double> num, std::optional<double> den, double scale = 1) {
+		if (!num || !den || *den == 0)
+			return "n/a";
+		char buf[32];
+		std::snprintf(buf, sizeof buf, format, *num / *den * scale);
+		return buf;
+	}
+
+	// bytes 为运算至少需要读写的矩阵数据量, 据此估计达到的带宽; 有计数器时再输出 IPC,
+	// 缓存与 TLB 缺失率, 以及按 LLC 缺失 (每次一个 64 字节缓存行) 估计的内存流量.
+	// 计数器取每次运行的平均值, 与最短耗时相除, 因此流量是略偏高的估计
+	void report(const std::string &name, double seconds, double flops, double bytes, double error) {
+		std::printf("%-28s %10.3f ms %9.2f GFLOP/s %8.2f GB/s   rel. error %.2e\n", name.c_str(), seconds * 1e3,
+		            flops / seconds * 1e-9, bytes / seconds * 1e-9, error);
+		if (!counters || !counters->available())
+			return;
+
+		const auto &s = last_sample;
+		std::printf("%-28s IPC %s, L1d miss %s%%, LLC miss %s%%, dTLB miss %s/kinstr, FP arith %s/flop, LLC traffic %s GB/s\n", "",
+		            ratio("%.2f", s[PerfCounters::Instructions], s[PerfCounters::Cycles]).c_str(),
+		            ratio("%.2f", s[PerfCounters::L1DMisses], s[PerfCounters::L1DLoads], 100).c_str(),
+		            ratio("%.2f", s[PerfCounters::LLCMisses], s[PerfCounters::LLCReferences], 100).c_str(),
+		            ratio("%.3f", s[PerfCounters::DTLBMisses], s[PerfCounters::Instructions], 1000).c_str(),
+		            ratio("%.3f", s[PerfCounters::FPArith], flops).c_str(),
+		            ratio("%.2f", s[PerfCounters::LLCMisses], seconds, 64e-9).c_str());
+	}
+
+	Matrix<double> random_matrix(std::size_t rows, std::size_t cols, unsigned seed, double diagonal = 0) {
+		std::mt19937 gen(seed);
+		std::uniform_real_distribution<double> dist(-1, 1);
+		Matrix<double> res(rows, cols);
+		for (std::size_t i = 0; i < rows; ++i) {
+			for (std::size_t j = 0; j < cols; ++j)
+				res(i, j) = dist(gen);
+			if (i < cols)
+				res(i, i) += diagonal;
+		}
+		return res;
+	}
+
+	void bench_multiply(std::size_t n, std::size_t repeats) {
+		std::printf("\nmultiply %zux%zu\n", n, n);
+		Matrix<float> af = detail::convert<float>(random_matrix(n, n, 1)), bf = detail::convert<float>(random_matrix(n, n, 2));
+		// double 路径使用同样 (可由 float 精确表示) 的输入, 误差只来自累加
+		Matrix<double> a = detail::convert<double>(af), b = detail::convert<double>(bf);
+		Matrix<double> reference = multiply(a, b);
+		double flops = 2.0 * n * n * n, bytes = 3.0 * n * n;
+
+		Matrix<double> d;
+		double seconds = best_of(repeats, [&] { d = multiply(a, b); });
+		report("double", seconds, flops, bytes * sizeof(double), max_error(d, reference));
+
+		// 每个工作进程单线程计算一段输出块, 进程数与线程池的并行度相同
+		SharedMatrix<double> sa(a), sb(b), sc;
+		seconds = best_of(repeats, [&] { sc = multiply(sa, sb); });
+		report("double (processes)", seconds, flops, bytes * sizeof(double), max_error(sc.to_matrix(), reference));
+
+		Matrix<float> c;
+		for (Precision p: {Precision::Single, Precision::Mixed}) {
+			seconds = best_of(repeats, [&] { c = multiply(af, bf, p); });
+			report(p == Precision::Single ? "float (Single)" : "float (Mixed)", seconds, flops, bytes * sizeof(float), max_error(c, reference));
+		}
+	}
+
+	void bench_solve(std::size_t n, std::size_t repeats) {
+		std::printf("\nsolve %zux%zu, %zu right-hand sides\n", n, n, std::size_t{16});
+		Matrix<double> a = random_matrix(n, n, 3, static_cast<double>(n) / 4), b = random_matrix(n, 16, 4);
+		Matrix<double> reference = LU<double>(a).solve(b);
+		double flops = 2.0 / 3.0 * n * n * n + 2.0 * 16 * n * n;
+		double bytes = (1.0 * n * n + 2.0 * 16 * n) * sizeof(double);
+
+		Matrix<double> x;
+		for (Precision p: {Precision::Double, Precision::Single, Precision::Mixed}) {
+			const char *name = p == Precision::Double ? "Double" : p == Precision::Single ? "Single" : "Mixed (refined)";
+			double seconds = best_of(repeats, [&] { x = solve(a, b, p); });
+			report(std::string("solve ") + name, seconds, flops, bytes, max_error(x, reference));
+		}
+	}
+
+	void bench_batched(std::size_t n, std::size_t batch, std::size_t repeats) {
+		std::printf("\nbatched multiply %zu x (%zux%zu)\n", batch, n, n);
+		Matrix<double> a = random_matrix(batch * n, n, 5), b = random_matrix(batch * n, n, 6), c(batch * n, n);
+		double flops = 2.0 * n * n * n * batch, bytes = 3.0 * n * n * batch * sizeof(double);
+
+		// 逐项调用 multiply: 每项都分配结果并做检查
+		std::vector<Matrix<double>> items(batch);
+		double seconds = best_of(repeats, [&] {
+			for (std::size_t t = 0; t < batch; ++t)
+				items[t] = multiply(a.view().block(t * n, 0, n, n), b.view().block(t * n, 0, n, n));
+		});
+		report("per-item multiply", seconds, flops, bytes, 0);
+
+		seconds = best_of(repeats, [&] {
+			gemm_strided_batched(1.0, a.view().block(0, 0, n, n), b.view().block(0, 0, n, n), 0.0, c.view().block(0, 0, n, n), batch);
+		});
+		report("gemm_strided_batched", seconds, flops, bytes, 0);
+	}
+
+	// 纯访存的核: 分块转置复制, 衡量带宽与 TLB 行为
+	void bench_transpose(std::size_t n, std::size_t repeats) {
+		std::printf("\nrelayout %zux%zu row-major -> column-major\n", n, n);
+		Matrix<double> a = random_matrix(n, n, 7);
+		Matrix<double, Layout::ColMajor> t;
+		double seconds = best_of(repeats, [&] { t = relayout<Layout::ColMajor>(a); });
+		report("relayout", seconds, 0, 2.0 * n * n * sizeof(double), 0);
+	}
+
+	void print_tuning(const TuningConfig &config) {
+		std::printf("[%s]\n", cpu_model().c_str());
+		for (auto [name, field]: detail::kTuningFields)
+			std::printf("%s = %zu\n", name, config.*field);
+	}
+
+}// namespace
+
+// 用法: bench [--perf] [size] [repeats]  --perf 时同时读取硬件计数器 (perf_event_open)
+//       bench --tune [size]    校准分块参数并写入配置文件 (tuning_path())
+//       bench --show-tuning    输出当前生效的参数
+int main(int argc, char **argv) {
+	std::string mode = argc > 1 ? argv[1] : "";
+	if (mode == "--show-tuning") {
+		print_tuning(tuning());
+		return 0;
+	}
+	if (mode == "--tune") {
+		TuneOptions opts;
+		opts.size = argc > 2 ? std::stoul(argv[2]) : opts.size;
+		opts.log = &std::cout;
+		TuningConfig config = autotune(opts);
+		save_tuning(config);
+		std::printf("\nsaved to %s\n", tuning_path().string().c_str());
+		print_tuning(config);
+		return 0;
+	}
+
+	// 计数器必须在线程池创建工作线程之前打开, 工作线程才会继承它们
+	std::optional<PerfCounters> perf;
+	if (mode == "--perf") {
+		perf.emplace();
+		if (perf->available())
+			counters = &*perf;
+		else
+			std::printf("perf counters unavailable: %s\n", perf->error().c_str());
+		--argc;
+		++argv;
+	}
+
+	std::size_t n = argc > 1 ? std::stoul(argv[1]) : 512;
+	std::size_t repeats = argc > 2 ? std::stoul(argv[2]) : 3;
+
+	std::printf("threads: %zu\n", ThreadPool::instance().concurrency());
+	bench_multiply(n, repeats);
+	bench_solve(n, repeats);
+	bench_batched(64, 1000, repeats);
+	bench_transpose(4 * n, repeats);
+
+	if constexpr (instrument::enabled) {
+		std::printf("\n");
+		std::fflush(stdout);
+		instrument::report(std::cout);
+	}
+	return 0;
+}
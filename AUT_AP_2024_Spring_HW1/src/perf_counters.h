@@ -0,0 +1,134 @@
+#ifndef AUT_AP_2024_Spring_HW1_PERF_COUNTERS
+#define AUT_AP_2024_Spring_HW1_PERF_COUNTERS
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <utility>
+
+#if __has_include(<linux/perf_event.h>)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define ALGEBRA_HAS_PERF_EVENT 1
+#endif
+
+// 基准程序使用的硬件性能计数器 (Linux perf_event_open).
+// 每个计数器单独打开, 某个事件不受支持 (虚拟机, 容器, 非 Intel 的原始事件) 时只缺少该项.
+// 计数器只统计用户态, 并由之后创建的线程继承, 因此需要在线程池启动之前构造.
+class PerfCounters {
+public:
+	enum Counter { Cycles,
+		           Instructions,
+		           L1DLoads,
+		           L1DMisses,
+		           LLCReferences,
+		           LLCMisses,
+		           DTLBMisses,
+		           FPArith,
+		           kCount };
+
+	using Sample = std::array<std::optional<double>, kCount>;
+
+	PerfCounters() {
+		fds.fill(-1);
+#ifdef ALGEBRA_HAS_PERF_EVENT
+		auto cache = [](std::uint64_t id, std::uint64_t op, std::uint64_t result) {
+			return id | (op << 8) | (result << 16);
+		};
+		const std::pair<std::uint32_t, std::uint64_t> events[kCount] = {
+				{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+				{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+				{PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_ACCESS)},
+				{PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+				{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES},
+				{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+				{PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+				// Intel FP_ARITH_INST_RETIRED (事件 0xC7, 所有 umask): 浮点运算指令数, 向量指令按一条计
+				{PERF_TYPE_RAW, 0xC7 | (0xFFull << 8)},
+		};
+		for (std::size_t c = 0; c < kCount; ++c) {
+			perf_event_attr attr{};
+			attr.size = sizeof attr;
+			attr.type = events[c].first;
+			attr.config = events[c].second;
+			attr.disabled = 1;
+			attr.inherit = 1;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+			fds[c] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+			if (fds[c] < 0 && message.empty())
+				message = std::strerror(errno);
+		}
+#else
+		message = "perf_event_open is not available on this platform";
+#endif
+	}
+
+	~PerfCounters() {
+#ifdef ALGEBRA_HAS_PERF_EVENT
+		for (int fd: fds)
+			if (fd >= 0)
+				close(fd);
+#endif
+	}
+
+	PerfCounters(const PerfCounters &) = delete;
+	PerfCounters &operator=(const PerfCounters &) = delete;
+
+	// 是否至少有一个计数器可用; 否则 error() 给出第一个失败的原因
+	bool available() const {
+		for (int fd: fds)
+			if (fd >= 0)
+				return true;
+		return false;
+	}
+
+	const std::string &error() const { return message; }
+
+	static const char *name(Counter c) {
+		static const char *names[kCount] = {"cycles", "instructions", "L1d loads", "L1d misses",
+		                                    "LLC references", "LLC misses", "dTLB misses", "FP arith"};
+		return names[c];
+	}
+
+	void start() {
+#ifdef ALGEBRA_HAS_PERF_EVENT
+		for (int fd: fds) {
+			if (fd >= 0) {
+				ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+				ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+			}
+		}
+#endif
+	}
+
+	// 停止计数并读出各计数器; 计数器被复用 (多路分时) 时按运行时间比例放大
+	Sample stop() {
+		Sample res{};
+#ifdef ALGEBRA_HAS_PERF_EVENT
+		for (std::size_t c = 0; c < kCount; ++c) {
+			if (fds[c] < 0)
+				continue;
+			ioctl(fds[c], PERF_EVENT_IOC_DISABLE, 0);
+			std::uint64_t data[3];
+			if (read(fds[c], data, sizeof data) != static_cast<ssize_t>(sizeof data) || data[2] == 0)
+				continue;
+			res[c] = static_cast<double>(data[0]) * static_cast<double>(data[1]) / static_cast<double>(data[2]);
+		}
+#endif
+		return res;
+	}
+
+private:
+	std::array<int, kCount> fds;
+	std::string message;
+};
+
+#endif// AUT_AP_2024_Spring_HW1_PERF_COUNTERS
@@ -1,9 +1,38 @@
 #include "algebra.h"
+#include "async.h"
+#include "blas.h"
+#include "chain.h"
+#include "cholesky.h"
+#include "complex.h"
+#include "eigen.h"
+#include "format.h"
+#include "instrument.h"
+#include "io.h"
+#include "kernel.h"
+#include "lu.h"
+#include "matrix.h"
+#include "power.h"
+#include "precision.h"
+#include "qr.h"
+#include "quantized.h"
+#include "reduction.h"
+#include "shm.h"
+#include "task_graph.h"
+#include "thread_pool.h"
+#include "tuner.h"
+#include "tuning.h"
+#include "unchecked.h"
+#include "update.h"
 
 #include <cmath>
+#include <filesystem>
+#include <fstream>
 #include <gtest/gtest.h>
 #include <iostream>
 #include <limits>
+#include <random>
+#include <sstream>
+#include <thread>
 
 using namespace algebra;
 
@@ -508,3 +537,1661 @@ TEST(AutAp2024SpringHW1, inverse_EmptyMatrix) {
 	EXPECT_ANY_THROW(inverse(mat))
 		<< "Inverse calculation should throw an error for an empty matrix.";
 }
+
+// "============================================="
+// "             Matrix / Layout Tests           "
+// "============================================="
+
+// Fill a nested matrix with reproducible small integers
+static MATRIX<int> random_nested(std::size_t rows, std::size_t cols,
+								 unsigned seed) {
+	std::mt19937 rand(seed);
+	std::uniform_int_distribution<int> dis(-9, 9);
+	MATRIX<int> mat(rows, std::vector<int>(cols));
+	for (auto &row : mat)
+		for (auto &elem : row)
+			elem = dis(rand);
+	return mat;
+}
+
+// Test that column-major storage keeps logical indexing
+TEST(AutAp2024SpringHW1, matrix_ColMajorIndexing) {
+	Matrix<int, Layout::ColMajor> mat = {{1, 2, 3}, {4, 5, 6}};
+	std::vector<int> expectedStorage = {1, 4, 2, 5, 3, 6};
+
+	EXPECT_EQ(mat(1, 0), 4);
+	EXPECT_EQ(mat(0, 2), 3);
+	EXPECT_EQ(std::vector<int>(mat.data(), mat.data() + mat.size()),
+			  expectedStorage)
+		<< "Column-major matrix should store columns contiguously.";
+	EXPECT_EQ(mat.to_nested(), (MATRIX<int>{{1, 2, 3}, {4, 5, 6}}));
+}
+
+// Test that transposing a view or an rvalue is a layout flip without copies
+TEST(AutAp2024SpringHW1, matrix_TransposeIsLayoutFlip) {
+	Matrix<int> mat = {{1, 2, 3}, {4, 5, 6}};
+	auto view = transpose(mat.view());
+	static_assert(decltype(view)::layout == Layout::ColMajor);
+
+	EXPECT_EQ(view.data(), mat.data()) << "Transposed view should alias data.";
+	EXPECT_EQ(view.rows(), 3u);
+	EXPECT_EQ(view(2, 1), 6);
+
+	const int *storage = mat.data();
+	auto moved = transpose(std::move(mat));
+	EXPECT_EQ(moved.data(), storage) << "Transposing an rvalue should not copy.";
+	EXPECT_EQ(moved.to_nested(), transpose(MATRIX<int>{{1, 2, 3}, {4, 5, 6}}));
+}
+
+// Test relayout round trip through a non-square matrix
+TEST(AutAp2024SpringHW1, matrix_RelayoutRoundTrip) {
+	Matrix<int> mat(random_nested(45, 70, 1));
+	auto col = relayout<Layout::ColMajor>(mat);
+
+	EXPECT_EQ(col.to_nested(), mat.to_nested());
+	EXPECT_EQ(relayout<Layout::RowMajor>(col), mat);
+}
+
+// Test multiplication for every combination of operand and result layouts
+TEST(AutAp2024SpringHW1, matrix_MultiplyAllLayouts) {
+	for (std::size_t n : {5u, 97u}) {
+		MATRIX<int> a = random_nested(n, n + 3, 2);
+		MATRIX<int> b = random_nested(n + 3, n + 1, 3);
+		MATRIX<int> expected = multiply(a, b);
+
+		Matrix<int> rowA(a), rowB(b);
+		Matrix<int, Layout::ColMajor> colA(a), colB(b);
+
+		EXPECT_EQ(multiply(rowA, rowB).to_nested(), expected);
+		EXPECT_EQ(multiply(rowA, colB).to_nested(), expected);
+		EXPECT_EQ(multiply(colA, rowB).to_nested(), expected);
+		EXPECT_EQ(multiply(colA, colB).to_nested(), expected);
+		EXPECT_EQ(multiply<Layout::ColMajor>(rowA, rowB).to_nested(), expected);
+		EXPECT_EQ(multiply<Layout::ColMajor>(colA, colB).to_nested(), expected);
+		EXPECT_EQ(multiply(transpose(colB.view()), transpose(colA.view())),
+				  Matrix<int>(transpose(expected)))
+			<< "Multiplying transposed views should give (AB)^T.";
+	}
+}
+
+// Test matrix multiplication with dimension mismatch
+TEST(AutAp2024SpringHW1, matrix_MultiplyDimensionMismatch) {
+	Matrix<int> matrixA(2, 2), matrixB(3, 2);
+
+	EXPECT_ANY_THROW(multiply(matrixA, matrixB))
+		<< "Matrix multiplication should throw on dimension mismatch.";
+	EXPECT_ANY_THROW(multiply(Matrix<int>{}, matrixA))
+		<< "Matrix multiplication with empty matrices should throw.";
+}
+
+// "============================================="
+// "             Copy-on-write Tests             "
+// "============================================="
+
+// Test that copies share storage until the first mutation
+TEST(AutAp2024SpringHW1, cow_CopySharesUntilWrite) {
+	Matrix<int> original = {{1, 2}, {3, 4}};
+	Matrix<int> copy = original;
+	std::vector<Matrix<int>> stored(3, original);
+
+	EXPECT_TRUE(copy.shares_storage_with(original));
+	EXPECT_TRUE(stored.back().shares_storage_with(original));
+
+	copy(0, 0) = 42;
+	EXPECT_FALSE(copy.shares_storage_with(original))
+		<< "Writing to a shared matrix should clone its buffer.";
+	EXPECT_EQ(original(0, 0), 1) << "Other copies must keep the old value.";
+	EXPECT_EQ(std::as_const(stored[0])(0, 0), 1);
+	EXPECT_EQ(copy(0, 0), 42);
+}
+
+// Test that transposing a lvalue shares the buffer and detaches on write
+TEST(AutAp2024SpringHW1, cow_TransposeSharesBuffer) {
+	const Matrix<int> mat = {{1, 2, 3}, {4, 5, 6}};
+	auto trans = transpose(mat);
+
+	EXPECT_TRUE(mat.shares_storage_with(trans));
+	trans(0, 1) = 0;
+	EXPECT_FALSE(mat.shares_storage_with(trans));
+	EXPECT_EQ(mat(1, 0), 4);
+	EXPECT_EQ(trans.to_nested(), (MATRIX<int>{{1, 0}, {2, 5}, {3, 6}}));
+}
+
+// Test that elementwise operations reuse an rvalue buffer in place
+TEST(AutAp2024SpringHW1, cow_ElementwiseReusesRvalue) {
+	Matrix<int> matrixA = {{10, 20}, {30, 40}};
+	Matrix<int, Layout::ColMajor> matrixB = {{1, 2}, {3, 4}};
+	const int *storage = std::as_const(matrixA).data();
+
+	auto diff = sum_sub(std::move(matrixA), matrixB, "sub");
+	EXPECT_EQ(std::as_const(diff).data(), storage);
+	EXPECT_EQ(diff.to_nested(), (MATRIX<int>{{9, 18}, {27, 36}}));
+
+	auto scaled = multiply(diff, 2);
+	EXPECT_EQ(diff.to_nested(), (MATRIX<int>{{9, 18}, {27, 36}}))
+		<< "Operations on a shared copy must not modify the input.";
+	EXPECT_EQ(hadamard_product(scaled, diff).to_nested(),
+			  (MATRIX<int>{{162, 648}, {1458, 2592}}));
+	EXPECT_ANY_THROW(sum_sub(diff, Matrix<int>(3, 2)));
+}
+
+// Test that threads can mutate their own copies of a shared matrix
+TEST(AutAp2024SpringHW1, cow_SharedAcrossThreads) {
+	const Matrix<int> shared(64, 64, 1);
+	std::vector<Matrix<int>> copies(4, shared);
+	std::vector<std::thread> threads;
+
+	for (std::size_t t = 0; t < copies.size(); ++t)
+		threads.emplace_back([&copies, t] {
+			copies[t] = multiply(copies[t], static_cast<int>(t));
+		});
+	for (auto &thread : threads)
+		thread.join();
+
+	for (std::size_t t = 0; t < copies.size(); ++t)
+		EXPECT_EQ(std::as_const(copies[t])(63, 63), static_cast<int>(t));
+	EXPECT_EQ(shared(63, 63), 1);
+}
+
+// "============================================="
+// "               reduction Tests               "
+// "============================================="
+
+// Test whole-matrix and per-axis sums for both layouts
+TEST(AutAp2024SpringHW1, reduction_SumAlongAxes) {
+	MATRIX<int> nested = {{1, 2, 3}, {4, 5, 6}};
+	Matrix<int> row(nested);
+	Matrix<int, Layout::ColMajor> col(nested);
+
+	EXPECT_EQ(sum(row), 21);
+	EXPECT_EQ(sum(col), 21);
+	EXPECT_EQ(sum(row, Axis::Row), (std::vector<int>{6, 15}));
+	EXPECT_EQ(sum(col, Axis::Row), (std::vector<int>{6, 15}));
+	EXPECT_EQ(sum(row, Axis::Column), (std::vector<int>{5, 7, 9}));
+	EXPECT_EQ(sum(col, Axis::Column), (std::vector<int>{5, 7, 9}));
+	EXPECT_EQ(sum(row.view().block(0, 1, 2, 2)), 16)
+		<< "Summing a strided sub-block failed.";
+}
+
+// Test that large per-axis sums match a scalar loop for every summation mode
+TEST(AutAp2024SpringHW1, reduction_LargeAxisSums) {
+	Matrix<int> mat(random_nested(300, 200, 4));
+	std::vector<int> rowSums(300), colSums(200);
+	for (std::size_t i = 0; i < 300; ++i)
+		for (std::size_t j = 0; j < 200; ++j) {
+			rowSums[i] += mat(i, j);
+			colSums[j] += mat(i, j);
+		}
+
+	for (auto method :
+		 {Summation::Naive, Summation::Pairwise, Summation::Kahan}) {
+		EXPECT_EQ(sum(mat, Axis::Row, {method}), rowSums);
+		EXPECT_EQ(sum(mat, Axis::Column, {method}), colSums);
+		EXPECT_EQ(sum(transpose(mat), Axis::Row, {method}), colSums);
+	}
+}
+
+// Test that compensated summation is accurate and independent of threads
+TEST(AutAp2024SpringHW1, reduction_CompensatedDeterministicSum) {
+	std::size_t n = 1 << 20;
+	Matrix<float> mat(1, n, 0.1f);
+	double exact = 0.1f * static_cast<double>(n);
+
+	float naive = 0;
+	for (std::size_t i = 0; i < n; ++i)
+		naive += 0.1f;
+
+	float kahan = sum(mat, {Summation::Kahan});
+	float pairwise = sum(mat, {Summation::Pairwise});
+	EXPECT_NEAR(kahan, exact, exact * 1e-6);
+	EXPECT_NEAR(pairwise, exact, exact * 1e-6);
+	EXPECT_GT(std::abs(naive - exact), std::abs(kahan - exact));
+
+	// The deterministic mode fixes chunk boundaries by size, so the result
+	// must equal a serial evaluation of the same chunks
+	std::size_t grain = detail::kReduceGrain;
+	std::vector<float> partials;
+	for (std::size_t lo = 0; lo < n; lo += grain)
+		partials.push_back(sum(mat.view().block(0, lo, 1, grain)));
+	Matrix<float> combined(1, partials.size());
+	std::copy(partials.begin(), partials.end(), combined.data());
+	EXPECT_EQ(pairwise, sum(combined))
+		<< "Deterministic sum must not depend on the thread count.";
+}
+
+// Test min, max and matrix norms
+TEST(AutAp2024SpringHW1, reduction_MinMaxNorms) {
+	Matrix<double, Layout::ColMajor> mat = {{1, -7, 3}, {4, 5, -2}};
+
+	EXPECT_EQ(min(mat), -7);
+	EXPECT_EQ(max(mat), 5);
+	EXPECT_EQ(min(mat, Axis::Row), (std::vector<double>{-7, -2}));
+	EXPECT_EQ(max(mat, Axis::Column), (std::vector<double>{4, 5, 3}));
+	EXPECT_NEAR(norm(mat), std::sqrt(104.0), 1e-12);
+	EXPECT_EQ(norm(mat, Norm::L1), 12);
+	EXPECT_EQ(norm(mat, Norm::Inf), 11);
+	EXPECT_EQ(norm(mat, Norm::Max), 7);
+	EXPECT_ANY_THROW(min(Matrix<double>{}));
+}
+
+// Test vector dot product
+TEST(AutAp2024SpringHW1, reduction_DotProduct) {
+	std::vector<double> x(100000, 0.5), y(100000, 4.0);
+
+	EXPECT_DOUBLE_EQ(dot(x, y), 200000.0);
+	EXPECT_DOUBLE_EQ(dot(x, y, {Summation::Kahan, false}), 200000.0);
+	EXPECT_ANY_THROW(dot(x, std::vector<double>(3)));
+}
+
+// "============================================="
+// "               gemv / ger Tests              "
+// "============================================="
+
+// Test matrix-vector products for both layouts and both operations
+TEST(AutAp2024SpringHW1, gemv_MatchesMatrixMultiply) {
+	MATRIX<int> nested = random_nested(150, 260, 5);
+	MATRIX<int> x = random_nested(260, 1, 6), xt = random_nested(150, 1, 7);
+	std::vector<int> xv(260), xtv(150), expected(150), expectedT(260);
+	for (std::size_t i = 0; i < 260; ++i)
+		xv[i] = x[i][0];
+	for (std::size_t i = 0; i < 150; ++i)
+		xtv[i] = xt[i][0];
+	auto ax = multiply(nested, x), atx = multiply(transpose(nested), xt);
+	for (std::size_t i = 0; i < 150; ++i)
+		expected[i] = ax[i][0];
+	for (std::size_t i = 0; i < 260; ++i)
+		expectedT[i] = atx[i][0];
+
+	Matrix<int> row(nested);
+	Matrix<int, Layout::ColMajor> col(nested);
+	EXPECT_EQ(gemv(row, xv), expected);
+	EXPECT_EQ(gemv(col, xv), expected);
+	EXPECT_EQ(gemv(row, xtv, Op::Trans), expectedT);
+	EXPECT_EQ(gemv(col, xtv, Op::Trans), expectedT);
+}
+
+// Test that gemv scales and accumulates into y
+TEST(AutAp2024SpringHW1, gemv_AlphaBetaAccumulate) {
+	Matrix<double> mat = {{1, 2}, {3, 4}};
+	std::vector<double> x = {1, 1}, y = {10, 20};
+
+	gemv(2.0, mat, x, 0.5, y);
+	EXPECT_EQ(y, (std::vector<double>{11, 24}));
+	gemv(1.0, transpose(mat.view()), x, 1.0, y);
+	EXPECT_EQ(y, (std::vector<double>{15, 30}));
+	EXPECT_ANY_THROW(gemv(1.0, mat, std::vector<double>(3), 0.0, y));
+}
+
+// Test rank-1 updates for both layouts
+TEST(AutAp2024SpringHW1, ger_RankOneUpdate) {
+	std::vector<int> x = {1, 2, 3}, y = {4, 5};
+
+	Matrix<int> row(3, 2, 0);
+	Matrix<int, Layout::ColMajor> col = {{1, 0}, {0, 1}, {0, 0}};
+	ger(1, x, y, row);
+	ger(1, x, y, col);
+	ger(1, x, y, row);
+	EXPECT_EQ(col.to_nested(), (MATRIX<int>{{5, 5}, {8, 11}, {12, 15}}));
+	EXPECT_EQ(row.to_nested(), (MATRIX<int>{{8, 10}, {16, 20}, {24, 30}}));
+	EXPECT_ANY_THROW(ger(1, y, x, row));
+}
+
+// "============================================="
+// "                  gemm Tests                 "
+// "============================================="
+
+// Test that gemm matches the composed multiply / sum_sub expression
+TEST(AutAp2024SpringHW1, gemm_FusedMultiplyAccumulate) {
+	MATRIX<int> a = random_nested(140, 300, 8), b = random_nested(300, 270, 9);
+	MATRIX<int> c = random_nested(140, 270, 10);
+	MATRIX<int> expected =
+		sum_sub(multiply(c, -2), multiply(multiply(a, b), 3));
+
+	Matrix<int> A(a), B(b), C(c);
+	Matrix<int, Layout::ColMajor> colC(c);
+	gemm(3, A, B, -2, C);
+	gemm(3, A, B, -2, colC);
+	EXPECT_EQ(C.to_nested(), expected);
+	EXPECT_EQ(colC.to_nested(), expected);
+}
+
+// Test transposition flags against explicitly transposed operands
+TEST(AutAp2024SpringHW1, gemm_TransposeFlags) {
+	MATRIX<int> a = random_nested(70, 40, 11), b = random_nested(50, 70, 12);
+	MATRIX<int> expected = multiply(transpose(a), transpose(b));
+
+	Matrix<int> A(a), B(b), C(40, 50, 7);
+	gemm(1, A, B, 0, C, Op::Trans, Op::Trans);
+	EXPECT_EQ(C.to_nested(), expected) << "beta = 0 must overwrite C.";
+
+	Matrix<int> At(transpose(a)), D(40, 50);
+	gemm(1, At, B, 0, D, Op::NoTrans, Op::Trans);
+	EXPECT_EQ(D, C);
+	EXPECT_ANY_THROW(gemm(1, A, B, 0, D));
+}
+
+// "============================================="
+// "             multiply_chain Tests            "
+// "============================================="
+
+// Test that the planner finds the cheapest parenthesisation
+TEST(AutAp2024SpringHW1, multiply_chain_OptimalPlan) {
+	ChainPlan plan({10, 100, 5, 50});
+	EXPECT_EQ(plan.cost(), 7500u);
+	EXPECT_EQ(plan.to_string(), "((A0A1)A2)");
+
+	ChainPlan vectorPlan({200, 200, 200, 200, 1});
+	EXPECT_EQ(vectorPlan.to_string(), "(A0(A1(A2A3)))")
+		<< "A chain ending in a vector should be evaluated right to left.";
+	EXPECT_EQ(vectorPlan.cost(), 3u * 200 * 200);
+}
+
+// Test that chain products match nested left-to-right multiplication
+TEST(AutAp2024SpringHW1, multiply_chain_MatchesNestedMultiply) {
+	std::vector<std::size_t> dims = {30, 90, 20, 110, 70, 1};
+	std::vector<MATRIX<int>> nested;
+	std::vector<Matrix<int, Layout::ColMajor>> matrices;
+	for (std::size_t i = 0; i + 1 < dims.size(); ++i) {
+		nested.push_back(random_nested(dims[i], dims[i + 1], 20 + i));
+		matrices.emplace_back(nested.back());
+	}
+
+	MATRIX<int> expected = nested[0];
+	for (std::size_t i = 1; i < nested.size(); ++i)
+		expected = multiply(expected, nested[i]);
+
+	EXPECT_EQ(multiply_chain(matrices).to_nested(), expected);
+	EXPECT_EQ(multiply_chain({matrices[1], matrices[2]}),
+			  multiply(matrices[1], matrices[2]));
+	EXPECT_EQ(multiply_chain({matrices[0]}).to_nested(), nested[0]);
+	EXPECT_ANY_THROW(multiply_chain({matrices[0], matrices[2]}));
+}
+
+// "============================================="
+// "            matrix_power / expm Tests        "
+// "============================================="
+
+// Test LU solve, determinant and inverse against the adjugate versions
+TEST(AutAp2024SpringHW1, lu_SolveDeterminantInverse) {
+	MATRIX<double> mat = {{1, 2, 3}, {0, 1, 4}, {5, 6, 0}};
+	LU lu(Matrix<double, Layout::ColMajor>{mat});
+
+	EXPECT_NEAR(lu.determinant(), determinant(mat), 1e-12);
+	auto inv = lu.inverse(), expected = Matrix<double>(inverse(mat));
+	for (std::size_t i = 0; i < 3; ++i)
+		for (std::size_t j = 0; j < 3; ++j)
+			EXPECT_NEAR(inv(i, j), expected(i, j), 1e-12);
+
+	auto x = lu.solve(std::vector<double>{14, 14, 17});
+	EXPECT_NEAR(x[0], 1, 1e-12);
+	EXPECT_NEAR(x[1], 2, 1e-12);
+	EXPECT_NEAR(x[2], 3, 1e-12);
+
+	LU singular(Matrix<double>{{1, 2}, {2, 4}});
+	EXPECT_TRUE(singular.singular());
+	EXPECT_EQ(singular.determinant(), 0);
+	EXPECT_ANY_THROW(singular.inverse());
+}
+
+// Test binary exponentiation against repeated multiplication
+TEST(AutAp2024SpringHW1, matrix_power_MatchesRepeatedMultiply) {
+	MATRIX<long long> mat = {{1, 1, 0}, {1, 0, 1}, {0, 1, 1}};
+	MATRIX<long long> expected = create_matrix<long long>(3, 3, MatrixType::Identity);
+	for (int k = 0; k <= 13; ++k) {
+		EXPECT_EQ(matrix_power(mat, k), expected) << "Power " << k << " failed.";
+		expected = multiply(expected, mat);
+	}
+
+	Matrix<long long, Layout::ColMajor> fib = {{1, 1}, {1, 0}};
+	EXPECT_EQ(matrix_power(fib, 90)(0, 1), 2880067194370816120LL)
+		<< "Fibonacci number F(90) via matrix power failed.";
+	EXPECT_ANY_THROW(matrix_power(Matrix<int>(2, 3), 2));
+}
+
+// Test the matrix exponential against closed forms
+TEST(AutAp2024SpringHW1, expm_ClosedForms) {
+	Matrix<double> nilpotent = {{0, 1}, {0, 0}};
+	EXPECT_EQ(expm(nilpotent), (Matrix<double>{{1, 1}, {0, 1}}));
+
+	for (double t : {0.01, 0.5, 2.0, 40.0}) {
+		Matrix<double, Layout::ColMajor> rotation = {{0, -t}, {t, 0}};
+		auto res = expm(rotation);
+		EXPECT_NEAR(res(0, 0), std::cos(t), 1e-12);
+		EXPECT_NEAR(res(0, 1), -std::sin(t), 1e-12);
+		EXPECT_NEAR(res(1, 0), std::sin(t), 1e-12);
+	}
+
+	Matrix<double> diag = {{5, 0, 0}, {0, -3, 0}, {0, 0, 0.1}};
+	auto res = expm(diag);
+	EXPECT_NEAR(res(0, 0), std::exp(5.0), 1e-10 * std::exp(5.0));
+	EXPECT_NEAR(res(1, 1), std::exp(-3.0), 1e-14);
+	EXPECT_NEAR(res(2, 2), std::exp(0.1), 1e-14);
+	EXPECT_NEAR(res(0, 1), 0.0, 1e-12);
+}
+
+// "============================================="
+// "             QR / least_squares Tests        "
+// "============================================="
+
+// Test that Q is orthonormal and Q * R reproduces a tall matrix
+TEST(AutAp2024SpringHW1, qr_ReconstructsMatrix) {
+	Matrix<double> mat(300, 70);
+	MATRIX<int> nested = random_nested(300, 70, 30);
+	for (std::size_t i = 0; i < 300; ++i)
+		for (std::size_t j = 0; j < 70; ++j)
+			mat(i, j) = nested[i][j];
+
+	QR qr(mat);
+	auto Q = qr.q(), R = qr.r();
+	auto product = multiply(Q, R);
+	auto gram = multiply(transpose(Q.view()), Q.view());
+
+	for (std::size_t i = 0; i < 300; ++i)
+		for (std::size_t j = 0; j < 70; ++j)
+			EXPECT_NEAR(product(i, j), mat(i, j), 1e-10);
+	for (std::size_t i = 0; i < 70; ++i) {
+		for (std::size_t j = 0; j < 70; ++j) {
+			EXPECT_NEAR(gram(i, j), i == j ? 1.0 : 0.0, 1e-12);
+			if (i > j) {
+				EXPECT_EQ(R(i, j), 0.0) << "R must be upper triangular.";
+			}
+		}
+	}
+}
+
+// Test least-squares line fitting on an overdetermined system
+TEST(AutAp2024SpringHW1, least_squares_LineFit) {
+	// y = 2 + 3x sampled with symmetric noise that cancels in the fit
+	Matrix<double> design(200, 2);
+	std::vector<double> y(200);
+	for (std::size_t i = 0; i < 200; ++i) {
+		design(i, 0) = 1;
+		design(i, 1) = static_cast<double>(i % 100);
+		y[i] = 2 + 3 * design(i, 1) + (i < 100 ? 0.5 : -0.5);
+	}
+
+	auto coef = least_squares(design, y);
+	EXPECT_NEAR(coef[0], 2, 1e-10);
+	EXPECT_NEAR(coef[1], 3, 1e-12);
+
+	Matrix<double> square = {{2, 1}, {1, 3}};
+	auto x = least_squares(square, Matrix<double>{{3, 1}, {4, 2}});
+	EXPECT_NEAR(x(0, 0), 1, 1e-12);
+	EXPECT_NEAR(x(1, 0), 1, 1e-12);
+	EXPECT_NEAR(x(0, 1), 0.2, 1e-12);
+	EXPECT_NEAR(x(1, 1), 0.6, 1e-12);
+
+	EXPECT_ANY_THROW(QR(Matrix<double>(2, 3)));
+	EXPECT_ANY_THROW(least_squares(Matrix<double>(3, 2), y));
+	EXPECT_ANY_THROW(least_squares(Matrix<double>(3, 2), std::vector<double>(3)));
+}
+
+// Test that collinear columns are rejected even when rounding leaves R(1, 1) slightly nonzero
+TEST(AutAp2024SpringHW1, least_squares_CollinearColumns) {
+	Matrix<double> design = {{0.1, 0.3}, {0.7, 2.1}, {1.3, 3.9}, {2.9, 8.7}};
+	EXPECT_THROW(least_squares(design, std::vector<double>{1, 2, 3, 4}), std::invalid_argument);
+	EXPECT_THROW(QR<double>(design).solve(Matrix<double>(4, 2)), std::invalid_argument);
+}
+
+// "============================================="
+// "             Cholesky Tests                  "
+// "============================================="
+
+// Test that L * L^T reproduces an SPD matrix larger than several blocks
+TEST(AutAp2024SpringHW1, cholesky_ReconstructsMatrix) {
+	// A = B * B^T + n * I 是对称正定的
+	Matrix<double> base(200, 200);
+	MATRIX<int> nested = random_nested(200, 200, 34);
+	for (std::size_t i = 0; i < 200; ++i)
+		for (std::size_t j = 0; j < 200; ++j)
+			base(i, j) = nested[i][j];
+	Matrix<double> spd = multiply(base, transpose(base));
+	for (std::size_t i = 0; i < 200; ++i)
+		spd(i, i) += 200;
+
+	Cholesky chol(spd);
+	ASSERT_TRUE(chol.positive_definite());
+	const auto &L = chol.factor();
+	auto product = multiply(L, transpose(L));
+	for (std::size_t i = 0; i < 200; ++i) {
+		for (std::size_t j = 0; j < 200; ++j) {
+			EXPECT_NEAR(product(i, j), spd(i, j), 1e-9 * spd(i, i));
+			if (j > i) {
+				EXPECT_EQ(L(i, j), 0.0) << "L must be lower triangular.";
+			}
+		}
+	}
+
+	LU lu(spd);
+	EXPECT_NEAR(chol.log_determinant(), SymmetricSolver<double>(spd).log_determinant(), 1e-9);
+	auto x = chol.solve(std::vector<double>(200, 1.0));
+	auto y = lu.solve(std::vector<double>(200, 1.0));
+	for (std::size_t i = 0; i < 200; ++i)
+		EXPECT_NEAR(x[i], y[i], 1e-12);
+}
+
+// Test solve / inverse / log_determinant and the LU fallback for non-SPD input
+TEST(AutAp2024SpringHW1, cholesky_SolveAndFallback) {
+	Matrix<double> spd = {{4, 2, 0}, {2, 5, 1}, {0, 1, 3}};
+	Cholesky chol(spd);
+	EXPECT_NEAR(chol.log_determinant(), std::log(44.0), 1e-12);
+	auto inv = chol.inverse();
+	auto identity = multiply(spd, inv);
+	for (std::size_t i = 0; i < 3; ++i)
+		for (std::size_t j = 0; j < 3; ++j)
+			EXPECT_NEAR(identity(i, j), i == j ? 1.0 : 0.0, 1e-12);
+
+	SymmetricSolver solver(spd);
+	EXPECT_TRUE(solver.uses_cholesky());
+
+	// 对称但不定: 通过廉价检查, 分解失败后回退到 LU
+	Matrix<double> indefinite = {{1, 2}, {2, 1}};
+	EXPECT_FALSE(Cholesky(indefinite).positive_definite());
+	EXPECT_ANY_THROW(Cholesky(indefinite).solve(std::vector<double>{1, 1}));
+	SymmetricSolver fallback(indefinite);
+	EXPECT_FALSE(fallback.uses_cholesky());
+	auto x = fallback.solve(std::vector<double>{3, 3});
+	EXPECT_NEAR(x[0], 1, 1e-12);
+	EXPECT_NEAR(x[1], 1, 1e-12);
+	EXPECT_ANY_THROW(fallback.log_determinant());
+
+	// 非对称矩阵直接使用 LU, 行列式为正时仍可取对数
+	Matrix<double> general = {{0, 1}, {-2, 0}};
+	SymmetricSolver lu_solver(general);
+	EXPECT_FALSE(lu_solver.uses_cholesky());
+	EXPECT_NEAR(lu_solver.log_determinant(), std::log(2.0), 1e-12);
+	EXPECT_ANY_THROW(Cholesky(Matrix<double>(2, 3)));
+}
+
+// "============================================="
+// "             Eigenvalue Tests                "
+// "============================================="
+
+// Test A * Z = Z * diag(w) and Z^T * Z = I for a random symmetric matrix
+TEST(AutAp2024SpringHW1, eigen_SymmetricDecomposition) {
+	const std::size_t n = 150;
+	Matrix<double> sym(n, n);
+	MATRIX<int> nested = random_nested(n, n, 35);
+	for (std::size_t i = 0; i < n; ++i)
+		for (std::size_t j = 0; j <= i; ++j)
+			sym(i, j) = sym(j, i) = nested[i][j];
+
+	SymmetricEigen eig(sym);
+	auto Z = eig.vectors();
+	const auto &w = eig.values();
+	EXPECT_TRUE(std::is_sorted(w.begin(), w.end()));
+
+	auto az = multiply(sym, Z);
+	auto gram = multiply(transpose(Z.view()), Z.view());
+	for (std::size_t i = 0; i < n; ++i) {
+		for (std::size_t j = 0; j < n; ++j) {
+			EXPECT_NEAR(az(i, j), Z(i, j) * w[j], 1e-9);
+			EXPECT_NEAR(gram(i, j), i == j ? 1.0 : 0.0, 1e-12);
+		}
+	}
+
+	auto values = eigenvalues(sym);
+	for (std::size_t i = 0; i < n; ++i)
+		EXPECT_NEAR(values[i], w[i], 1e-9);
+
+	Matrix<double> small = {{2, 1, 0}, {1, 2, 1}, {0, 1, 2}};
+	auto ws = eigenvalues(small);
+	EXPECT_NEAR(ws[0], 2 - std::sqrt(2.0), 1e-14);
+	EXPECT_NEAR(ws[1], 2, 1e-14);
+	EXPECT_NEAR(ws[2], 2 + std::sqrt(2.0), 1e-14);
+	EXPECT_ANY_THROW(SymmetricEigen(Matrix<double>(2, 3)));
+}
+
+// Test block power iteration against a matrix with a known spectrum
+TEST(AutAp2024SpringHW1, eigen_DominantEigenpairs) {
+	// A = Q * diag(d) * Q^T, 最大的几个特征值中包含负值
+	const std::size_t n = 300;
+	Matrix<double> random(n, n);
+	MATRIX<int> nested = random_nested(n, n, 36);
+	for (std::size_t i = 0; i < n; ++i)
+		for (std::size_t j = 0; j < n; ++j)
+			random(i, j) = nested[i][j];
+	auto Q = QR(random).q();
+
+	std::vector<double> d(n);
+	for (std::size_t i = 0; i < n; ++i)
+		d[i] = 1.0 / (1.0 + static_cast<double>(i));
+	d[0] = 100, d[1] = -90, d[2] = 80, d[3] = 50;
+
+	Matrix<double, Layout::ColMajor> scaled = Q;
+	for (std::size_t j = 0; j < n; ++j)
+		for (std::size_t i = 0; i < n; ++i)
+			scaled(i, j) *= d[j];
+	auto A = multiply(scaled, transpose(Q));
+
+	auto pairs = dominant_eigenpairs(A, 3);
+	ASSERT_TRUE(pairs.converged);
+	EXPECT_NEAR(pairs.values[0], 100, 1e-8);
+	EXPECT_NEAR(pairs.values[1], -90, 1e-8);
+	EXPECT_NEAR(pairs.values[2], 80, 1e-8);
+	for (std::size_t j = 0; j < 3; ++j) {
+		// 特征向量只确定到符号
+		double sign = pairs.vectors(0, j) * Q(0, j) < 0 ? -1 : 1;
+		for (std::size_t i = 0; i < n; ++i)
+			EXPECT_NEAR(sign * pairs.vectors(i, j), Q(i, j), 1e-8);
+	}
+	EXPECT_ANY_THROW(dominant_eigenpairs(A, 0));
+}
+
+// "============================================="
+// "             slogdet Tests                   "
+// "============================================="
+
+// Test slogdet on matrices whose determinant overflows or underflows a double
+TEST(AutAp2024SpringHW1, slogdet_OverflowSafe) {
+	// 上三角矩阵, 对角元交替为 +-1e3, 再交换两行: det = -(1e3)^400
+	const std::size_t n = 400;
+	Matrix<double> upper(n, n);
+	MATRIX<int> nested = random_nested(n, n, 36);
+	for (std::size_t i = 0; i < n; ++i) {
+		upper(i, i) = i % 2 == 0 ? 1e3 : -1e3;
+		for (std::size_t j = i + 1; j < n; ++j)
+			upper(i, j) = nested[i][j];
+	}
+	Matrix<double> swapped = upper;
+	for (std::size_t j = 0; j < n; ++j)
+		std::swap(swapped(0, j), swapped(n - 1, j));
+
+	auto [sign, log_abs] = slogdet(swapped);
+	EXPECT_EQ(sign, -1);
+	EXPECT_NEAR(log_abs, n * std::log(1e3), 1e-9);
+
+	// 对称正定路径: (1e-200 * I) 的行列式下溢为 0
+	Matrix<double> tiny(n, n);
+	for (std::size_t i = 0; i < n; ++i)
+		tiny(i, i) = 1e-200;
+	auto res = slogdet(tiny);
+	EXPECT_EQ(res.sign, 1);
+	EXPECT_NEAR(res.log_abs, n * std::log(1e-200), 1e-12 * n * 460);
+
+	// 与余子式展开的 determinant 一致
+	MATRIX<int> small = {{1, 2, 3}, {4, 5, 6}, {7, 8, 10}};
+	auto small_res = slogdet(small);
+	EXPECT_EQ(small_res.sign, -1);
+	EXPECT_NEAR(small_res.log_abs, std::log(std::abs(determinant(small))), 1e-12);
+
+	auto singular = slogdet(MATRIX<double>{{1, 2}, {2, 4}});
+	EXPECT_EQ(singular.sign, 0);
+	EXPECT_TRUE(std::isinf(singular.log_abs));
+	EXPECT_ANY_THROW(slogdet(MATRIX<double>{{1, 2}}));
+}
+
+// Test that the blocked LU spans several panels and still solves accurately
+TEST(AutAp2024SpringHW1, lu_BlockedFactorization) {
+	const std::size_t n = 300;
+	Matrix<double> mat(n, n);
+	MATRIX<int> nested = random_nested(n, n, 37);
+	for (std::size_t i = 0; i < n; ++i)
+		for (std::size_t j = 0; j < n; ++j)
+			mat(i, j) = nested[i][j];
+
+	LU lu(mat);
+	std::vector<double> b(n);
+	for (std::size_t i = 0; i < n; ++i)
+		b[i] = static_cast<double>(i % 7) - 3;
+	auto x = lu.solve(b);
+	auto ax = gemv(mat, x);
+	for (std::size_t i = 0; i < n; ++i)
+		EXPECT_NEAR(ax[i], b[i], 1e-9);
+
+	// P * A = L * U
+	const auto &f = lu.factors();
+	for (std::size_t i = 0; i < n; i += 37) {
+		for (std::size_t j = 0; j < n; j += 11) {
+			double s = 0;
+			for (std::size_t p = 0; p <= std::min(i, j); ++p)
+				s += (p == i ? 1.0 : f(i, p)) * f(p, j);
+			EXPECT_NEAR(s, mat(lu.pivots()[i], j), 1e-9);
+		}
+	}
+}
+
+// "============================================="
+// "             UpdatableInverse Tests          "
+// "============================================="
+
+// Test a sequence of Sherman-Morrison-Woodbury updates against a fresh LU
+TEST(AutAp2024SpringHW1, update_MatchesRecomputation) {
+	const std::size_t n = 80;
+	Matrix<double> mat(n, n);
+	MATRIX<int> nested = random_nested(n, n + 4, 38);
+	for (std::size_t i = 0; i < n; ++i) {
+		for (std::size_t j = 0; j < n; ++j)
+			mat(i, j) = nested[i][j];
+		mat(i, i) += 100;
+	}
+
+	UpdatableInverse updatable(mat);
+	auto expect_consistent = [&](const char *step) {
+		LU lu(updatable.matrix());
+		auto fresh = lu.inverse();
+		for (std::size_t i = 0; i < n; ++i)
+			for (std::size_t j = 0; j < n; ++j)
+				ASSERT_NEAR(updatable.inverse()(i, j), fresh(i, j), 1e-10) << step;
+		auto [sign, log_abs] = lu.slogdet();
+		EXPECT_EQ(updatable.slogdet().sign, sign) << step;
+		EXPECT_NEAR(updatable.slogdet().log_abs, log_abs, 1e-10) << step;
+	};
+
+	std::vector<double> u(n), v(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		u[i] = nested[i][n];
+		v[i] = nested[i][n + 1];
+	}
+	updatable.rank_one_update(u, v);
+	expect_consistent("rank_one_update");
+
+	Matrix<double> U(n, 3), V(n, 3);
+	for (std::size_t i = 0; i < n; ++i)
+		for (std::size_t j = 0; j < 3; ++j)
+			U(i, j) = V(i, j) = nested[i][n + 1 + j] / 4.0;
+	updatable.rank_update(U, V);
+	expect_consistent("rank_update");
+
+	std::vector<double> row(n, 1.0);
+	row[5] = -150;
+	updatable.replace_row(5, row);
+	expect_consistent("replace_row");
+
+	std::vector<double> col(n, -2.0);
+	col[7] = 120;
+	updatable.replace_column(7, col);
+	expect_consistent("replace_column");
+	EXPECT_EQ(updatable.updates(), 4);
+	EXPECT_EQ(updatable.matrix()(5, 0), 1.0);
+	EXPECT_EQ(updatable.matrix()(0, 7), -2.0);
+
+	auto x = updatable.solve(u);
+	auto ax = gemv(updatable.matrix(), x);
+	for (std::size_t i = 0; i < n; ++i)
+		EXPECT_NEAR(ax[i], u[i], 1e-10);
+}
+
+// Test that updates which would make the matrix singular are rejected without side effects
+TEST(AutAp2024SpringHW1, update_SingularUpdateRejected) {
+	UpdatableInverse updatable(Matrix<double>{{2, 1}, {1, 3}});
+	EXPECT_NEAR(updatable.determinant(), 5, 1e-12);
+
+	EXPECT_ANY_THROW(updatable.replace_row(1, std::vector<double>{2, 1}));
+	EXPECT_NEAR(updatable.determinant(), 5, 1e-12);
+	EXPECT_EQ(updatable.matrix()(1, 0), 1.0);
+
+	updatable.replace_row(1, std::vector<double>{0, 1});
+	EXPECT_NEAR(updatable.determinant(), 2, 1e-12);
+	EXPECT_NEAR(updatable.inverse()(0, 1), -0.5, 1e-12);
+
+	// Rank-2 update to a singular matrix; rounding leaves a tiny but nonzero pivot
+	Matrix<double> target{{0.1, 0.3}, {0.7, 2.1}};
+	Matrix<double> u{{1, 0}, {0, 1}}, v(2, 2);
+	for (std::size_t i = 0; i < 2; ++i)
+		for (std::size_t j = 0; j < 2; ++j)
+			v(j, i) = target(i, j) - updatable.matrix()(i, j);
+	EXPECT_ANY_THROW(updatable.rank_update(u, v));
+	EXPECT_NEAR(updatable.determinant(), 2, 1e-12);
+	EXPECT_EQ(updatable.matrix()(0, 0), 2.0);
+
+	EXPECT_ANY_THROW(updatable.replace_column(2, std::vector<double>{1, 1}));
+	EXPECT_ANY_THROW(updatable.rank_one_update(std::vector<double>{1}, std::vector<double>{1, 1}));
+	EXPECT_ANY_THROW(UpdatableInverse(Matrix<double>{{1, 2}, {2, 4}}));
+}
+
+// "============================================="
+// "             Quantized GEMM Tests            "
+// "============================================="
+
+// Reference (A - za) * (B - zb) accumulated in int64
+template<typename TA, typename TB>
+static Matrix<std::int64_t> quantized_reference(const Matrix<TA> &a, int za, const Matrix<TB> &b, int zb) {
+	Matrix<std::int64_t> res(a.rows(), b.cols());
+	for (std::size_t i = 0; i < a.rows(); ++i)
+		for (std::size_t j = 0; j < b.cols(); ++j)
+			for (std::size_t p = 0; p < a.cols(); ++p)
+				res(i, j) += (std::int64_t{a(i, p)} - za) * (std::int64_t{b(p, j)} - zb);
+	return res;
+}
+
+// Test every 8/16-bit operand combination with extreme values and zero points
+TEST(AutAp2024SpringHW1, quantized_GemmAllTypes) {
+	std::mt19937 gen(38);
+	auto fill = [&gen]<typename Q>(Matrix<Q> &m) {
+		// int16 取较小的范围, 使 77 项之和不超过 int32
+		int lo = sizeof(Q) == 1 ? std::numeric_limits<Q>::min() : -4000;
+		int hi = sizeof(Q) == 1 ? std::numeric_limits<Q>::max() : 4000;
+		std::uniform_int_distribution<int> dist(lo, hi);
+		for (std::size_t i = 0; i < m.rows(); ++i)
+			for (std::size_t j = 0; j < m.cols(); ++j)
+				m(i, j) = static_cast<Q>(dist(gen));
+	};
+	auto check = [&]<typename TA, typename TB>(TA, TB, int za, int zb) {
+		// k = 77 不是对齐长度的倍数, 检验补零部分
+		Matrix<TA> a(19, 77);
+		Matrix<TB> b(77, 23);
+		fill(a);
+		fill(b);
+		if constexpr (sizeof(TA) == 1 && sizeof(TB) == 1) {
+			a(0, 0) = std::numeric_limits<TA>::max();
+			b(0, 0) = std::numeric_limits<TB>::min();
+		}
+		auto res = quantized_gemm(a, za, b, zb);
+		auto ref = quantized_reference(a, za, b, zb);
+		for (std::size_t i = 0; i < res.rows(); ++i)
+			for (std::size_t j = 0; j < res.cols(); ++j)
+				ASSERT_EQ(res(i, j), ref(i, j)) << sizeof(TA) << "x" << sizeof(TB) << " at " << i << "," << j;
+	};
+
+	check(std::uint8_t{}, std::int8_t{}, 128, 0);
+	check(std::int8_t{}, std::int8_t{}, -3, 5);
+	check(std::uint8_t{}, std::uint8_t{}, 7, 250);
+	check(std::int8_t{}, std::uint8_t{}, 0, 128);
+	check(std::int16_t{}, std::int16_t{}, 100, -100);
+	check(std::uint8_t{}, std::int16_t{}, 3, 0);
+
+	// 非连续的转置视图同样可以作为操作数
+	Matrix<std::int8_t> a = {{1, -2}, {3, 4}, {-5, 6}};
+	auto res = quantized_gemm(transpose(a.view()), 0, a, 1);
+	EXPECT_EQ(res(0, 0), 1 * 0 + 3 * 2 + -5 * -6);
+	EXPECT_ANY_THROW(quantized_gemm(a, 0, a, 0));
+}
+
+// Test quantize / dequantize / requantize round trips against float multiply
+TEST(AutAp2024SpringHW1, quantized_MultiplyWithScales) {
+	Matrix<float> x = {{0.5f, -1.f, 0.25f}, {1.f, 0.f, -0.5f}};
+	Matrix<float> w = {{1.f, 0.5f}, {-0.5f, 1.f}, {0.25f, -1.f}};
+	QuantParams qx{1.f / 64, 128}, qw{1.f / 127, 0}, qy{1.f / 32, -10};
+
+	auto xq = quantize<std::uint8_t>(x, qx);
+	auto wq = quantize<std::int8_t>(w, qw);
+	EXPECT_EQ(xq(0, 0), 160);
+	EXPECT_EQ(wq(2, 1), -127);
+
+	auto expected = multiply(x, w);
+	auto y = dequantized_multiply(xq, qx, wq, qw);
+	auto yq = quantized_multiply<std::int8_t>(xq, qx, wq, qw, qy);
+	for (std::size_t i = 0; i < 2; ++i) {
+		for (std::size_t j = 0; j < 2; ++j) {
+			EXPECT_NEAR(y(i, j), expected(i, j), 0.02f);
+			EXPECT_NEAR(qy.scale * static_cast<float>(yq(i, j) - qy.zero_point), expected(i, j), 0.05f);
+		}
+	}
+
+	// 超出输出范围时饱和
+	auto saturated = quantized_multiply<std::int8_t>(xq, qx, wq, qw, QuantParams{1.f / 1024, 0});
+	EXPECT_EQ(saturated(0, 0), 127);
+	EXPECT_ANY_THROW(quantize<std::int8_t>(x, QuantParams{0.f, 0}));
+}
+
+// "============================================="
+// "             Precision Policy Tests          "
+// "============================================="
+
+// Test that double accumulation of float data matches a double reference more closely
+TEST(AutAp2024SpringHW1, precision_MixedMultiply) {
+	const std::size_t m = 40, k = 3000, n = 30;
+	std::mt19937 gen(39);
+	std::uniform_real_distribution<float> dist(0.f, 1.f);
+	Matrix<float> a(m, k);
+	Matrix<float, Layout::ColMajor> b(k, n);
+	for (std::size_t i = 0; i < a.size(); ++i)
+		a.data()[i] = dist(gen);
+	for (std::size_t i = 0; i < b.size(); ++i)
+		b.data()[i] = dist(gen);
+
+	auto single = multiply(a, b, Precision::Single);
+	auto mixed = multiply(a, b, Precision::Mixed);
+	auto twice = multiply(a, b, Precision::Double);
+
+	double err_single = 0, err_mixed = 0;
+	for (std::size_t i = 0; i < m; ++i) {
+		for (std::size_t j = 0; j < n; ++j) {
+			double ref = 0;
+			for (std::size_t p = 0; p < k; ++p)
+				ref += static_cast<double>(a(i, p)) * b(p, j);
+			err_single = std::max(err_single, std::abs(single(i, j) - ref) / ref);
+			err_mixed = std::max(err_mixed, std::abs(mixed(i, j) - ref) / ref);
+			// 只在最后舍入一次: 误差不超过半个 float ulp
+			EXPECT_LE(std::abs(mixed(i, j) - ref) / ref, 0.6 * std::numeric_limits<float>::epsilon());
+			EXPECT_EQ(mixed(i, j), twice(i, j));
+		}
+	}
+	EXPECT_LT(err_mixed, err_single);
+	EXPECT_ANY_THROW(multiply(a, a, Precision::Mixed));
+}
+
+// Test float factorization with iterative refinement to double accuracy
+TEST(AutAp2024SpringHW1, precision_IterativeRefinement) {
+	const std::size_t n = 150;
+	Matrix<double> mat(n, n);
+	MATRIX<int> nested = random_nested(n, n, 40);
+	for (std::size_t i = 0; i < n; ++i) {
+		for (std::size_t j = 0; j < n; ++j)
+			mat(i, j) = nested[i][j] + 0.1 * std::sin(static_cast<double>(i * n + j));
+		mat(i, i) += 50;
+	}
+	std::vector<double> b(n);
+	for (std::size_t i = 0; i < n; ++i)
+		b[i] = std::cos(static_cast<double>(i));
+
+	auto reference = LU(mat).solve(b);
+	PrecisionSolver single(mat, Precision::Single), mixed(mat, Precision::Mixed);
+	auto xs = single.solve(b);
+	auto xm = mixed.solve(b);
+	EXPECT_FALSE(mixed.fell_back());
+	EXPECT_GE(mixed.iterations(), 1u);
+	EXPECT_LE(mixed.iterations(), 5u);
+
+	double err_single = 0, err_mixed = 0;
+	for (std::size_t i = 0; i < n; ++i) {
+		err_single = std::max(err_single, std::abs(xs[i] - reference[i]));
+		err_mixed = std::max(err_mixed, std::abs(xm[i] - reference[i]));
+	}
+	EXPECT_GT(err_single, 1e-10);
+	EXPECT_LT(err_mixed, 1e-13);
+
+	auto inv = inverse(mat, Precision::Mixed);
+	auto identity = multiply(mat, inv);
+	for (std::size_t i = 0; i < n; ++i)
+		for (std::size_t j = 0; j < n; ++j)
+			EXPECT_NEAR(identity(i, j), i == j ? 1.0 : 0.0, 1e-12);
+
+	// Hilbert 矩阵在 float 中几乎奇异, 精化不收敛时改用 double 分解
+	Matrix<double> hilbert(10, 10);
+	for (std::size_t i = 0; i < 10; ++i)
+		for (std::size_t j = 0; j < 10; ++j)
+			hilbert(i, j) = 1.0 / static_cast<double>(i + j + 1);
+	PrecisionSolver ill(hilbert, Precision::Mixed);
+	auto xh = ill.solve(std::vector<double>(10, 1.0));
+	auto expected = LU(hilbert).solve(std::vector<double>(10, 1.0));
+	EXPECT_TRUE(ill.fell_back());
+	for (std::size_t i = 0; i < 10; ++i)
+		EXPECT_EQ(xh[i], expected[i]);
+}
+
+// "============================================="
+// "             Complex Matrix Tests            "
+// "============================================="
+
+using cd = std::complex<double>;
+
+static Matrix<cd> random_complex(std::size_t rows, std::size_t cols, unsigned seed) {
+	MATRIX<int> re = random_nested(rows, cols, seed), im = random_nested(rows, cols, seed + 1000);
+	Matrix<cd> res(rows, cols);
+	for (std::size_t i = 0; i < rows; ++i)
+		for (std::size_t j = 0; j < cols; ++j)
+			res(i, j) = cd(re[i][j], im[i][j]);
+	return res;
+}
+
+// Test random complex matrices with separate real / imaginary bounds
+TEST(AutAp2024SpringHW1, complex_CreateRandomMatrix) {
+	auto matrix = create_matrix<cd>(4, 5, MatrixType::Random, cd(-1, 2), cd(1, 3));
+	for (const auto &row: matrix) {
+		for (const auto &elem: row) {
+			EXPECT_GE(elem.real(), -1.0);
+			EXPECT_LE(elem.real(), 1.0);
+			EXPECT_GE(elem.imag(), 2.0);
+			EXPECT_LE(elem.imag(), 3.0);
+		}
+	}
+	EXPECT_ANY_THROW(create_matrix<cd>(2, 2, MatrixType::Random, cd(0, 1), cd(1, 1)));
+	EXPECT_ANY_THROW(create_matrix<cd>(2, 2, MatrixType::Random, std::nullopt, cd(1, 1)));
+	auto identity = create_matrix<cd>(2, 2, MatrixType::Identity);
+	EXPECT_EQ(identity[1][1], cd(1, 0));
+}
+
+// Test split-plane complex GEMM and conjugate transposes against a scalar reference
+TEST(AutAp2024SpringHW1, complex_GemmAndConjTranspose) {
+	Matrix<cd> a = random_complex(70, 60, 41);
+	Matrix<cd, Layout::ColMajor> b{random_complex(60, 50, 42).to_nested()};
+	auto c = multiply(a, b);
+	for (std::size_t i = 0; i < 70; ++i) {
+		for (std::size_t j = 0; j < 50; ++j) {
+			cd ref{};
+			for (std::size_t p = 0; p < 60; ++p)
+				ref += a(i, p) * b(p, j);
+			ASSERT_EQ(c(i, j), ref);
+		}
+	}
+
+	auto ah = conj_transpose(a);
+	EXPECT_EQ(ah.rows(), 60u);
+	EXPECT_EQ(ah(3, 5), std::conj(a(5, 3)));
+	auto gram = multiply(ah, a);
+	EXPECT_TRUE(is_hermitian(gram));
+	EXPECT_FALSE(is_hermitian(c));
+
+	// C = A^H * A 通过 gemm 的 ConjTrans 直接计算
+	Matrix<cd> h(60, 60);
+	gemm(cd(1), a, a, cd(0), h, Op::ConjTrans);
+	EXPECT_EQ(h, Matrix<cd>(gram));
+
+	std::vector<cd> x(70, cd(1, -1));
+	auto y = gemv(a, x, Op::ConjTrans);
+	auto ref = gemv(ah, x);
+	for (std::size_t i = 0; i < 60; ++i)
+		EXPECT_NEAR(std::abs(y[i] - ref[i]), 0.0, 1e-12);
+	EXPECT_NEAR(norm(a, Norm::Max), std::abs(cd(9, 9)), 1e-12);
+}
+
+// Test complex LU solve and determinant
+TEST(AutAp2024SpringHW1, complex_LUSolve) {
+	const std::size_t n = 120;
+	Matrix<cd> a = random_complex(n, n, 43);
+	std::vector<cd> b(n);
+	for (std::size_t i = 0; i < n; ++i)
+		b[i] = cd(std::cos(static_cast<double>(i)), std::sin(static_cast<double>(i)));
+
+	LU lu(a);
+	auto x = lu.solve(b);
+	auto ax = gemv(a, x);
+	for (std::size_t i = 0; i < n; ++i)
+		EXPECT_NEAR(std::abs(ax[i] - b[i]), 0.0, 1e-10);
+
+	// det([[1, i], [i, 1]]) = 1 - i^2 = 2
+	LU small(Matrix<cd>{{cd(1), cd(0, 1)}, {cd(0, 1), cd(1)}});
+	EXPECT_NEAR(std::abs(small.determinant() - cd(2)), 0.0, 1e-14);
+	auto inv = small.inverse();
+	EXPECT_NEAR(std::abs(inv(0, 1) - cd(0, -0.5)), 0.0, 1e-14);
+}
+
+// "============================================="
+// "             Formatter Tests                 "
+// "============================================="
+
+// Test display output format for nested and Matrix inputs
+TEST(AutAp2024SpringHW1, format_Display) {
+	MATRIX<int> nested{{1, -20}, {300, 4}};
+	std::ostringstream out;
+	display(nested, {}, out);
+	EXPECT_EQ(out.str(), "|   1   |  -20  |\n|  300  |   4   |\n");
+
+	std::ostringstream view_out;
+	display(Matrix<int>(nested), {}, view_out);
+	EXPECT_EQ(view_out.str(), out.str());
+
+	FormatOptions opts;
+	opts.width = 6;
+	opts.precision = 2;
+	opts.align = Align::Right;
+	MatrixFormatter formatter(opts);
+	Matrix<double> d{{1.5, -0.125}, {1e6, 2}};
+	EXPECT_EQ(formatter.to_string(2, 2, [&](std::size_t i, std::size_t j) { return d(i, j); }),
+	          "|  1.50| -0.12|\n|1000000.00|  2.00|\n");
+
+	opts.precision = -1;
+	opts.align = Align::Left;
+	opts.width = 0;
+	Matrix<std::complex<double>> c{{{1, 2}, {0.5, -1}}};
+	std::ostringstream complex_out;
+	display(c, opts, complex_out);
+	EXPECT_EQ(complex_out.str(), "|1+2i|0.5-1i|\n");
+}
+
+// Test head/tail summary mode on a large matrix
+TEST(AutAp2024SpringHW1, format_EdgeItems) {
+	const std::size_t n = 1000;
+	Matrix<int> m(n, n);
+	for (std::size_t i = 0; i < n; ++i)
+		for (std::size_t j = 0; j < n; ++j)
+			m(i, j) = static_cast<int>(i * n + j);
+
+	FormatOptions opts;
+	opts.edge_items = 1;
+	opts.width = 3;
+	std::ostringstream out;
+	display(m, opts, out);
+	EXPECT_EQ(out.str(), "| 0 |...|999|\n|...|...|...|\n|999000|...|999999|\n");
+
+	// 不截断时输出超过缓冲区大小, 需要分块写出
+	std::ostringstream full;
+	display(m, {}, full);
+	std::string text = full.str();
+	EXPECT_EQ(static_cast<std::size_t>(std::count(text.begin(), text.end(), '\n')), n);
+	EXPECT_EQ(text.size(), n * (n * 8 + 2));
+	EXPECT_EQ(text.substr(text.size() - 10), "|999999 |\n");
+}
+
+// "============================================="
+// "             Matrix IO Tests                 "
+// "============================================="
+
+// Test CSV parsing, including multi-chunk files loaded through mmap
+TEST(AutAp2024SpringHW1, io_LoadCsv) {
+	auto m = parse_csv("1, 2.5,-3\r\n\n  +4,5e-1 ,6\r\n");
+	EXPECT_EQ(m, (Matrix<double>{{1, 2.5, -3}, {4, 0.5, 6}}));
+	EXPECT_EQ(parse_csv<int>("1;2\n3;4", ';'), (Matrix<int>{{1, 2}, {3, 4}}));
+	EXPECT_TRUE(parse_csv("").empty());
+	EXPECT_THROW(parse_csv("1,2\n3\n"), std::invalid_argument);
+	EXPECT_THROW(parse_csv("1,2\n3,x\n"), std::invalid_argument);
+
+	// 超过一个解析块, 验证各块的行号偏移
+	const std::size_t rows = 300000, cols = 3;
+	auto path = std::filesystem::temp_directory_path() / "algebra_io_test.csv";
+	{
+		std::ofstream out(path);
+		out.precision(17);
+		for (std::size_t i = 0; i < rows; ++i)
+			out << i << ',' << static_cast<double>(i) / 4 << ',' << -static_cast<long>(i) << '\n';
+	}
+	auto big = load_csv<double, Layout::ColMajor>(path.string());
+	std::filesystem::remove(path);
+	ASSERT_EQ(big.rows(), rows);
+	ASSERT_EQ(big.cols(), cols);
+	for (std::size_t i = 0; i < rows; i += 997) {
+		EXPECT_EQ(big(i, 0), static_cast<double>(i));
+		EXPECT_EQ(big(i, 1), static_cast<double>(i) / 4);
+		EXPECT_EQ(big(i, 2), -static_cast<double>(i));
+	}
+	EXPECT_EQ(big(rows - 1, 0), static_cast<double>(rows - 1));
+	EXPECT_THROW(load_csv("/nonexistent/algebra.csv"), std::runtime_error);
+}
+
+// Test Matrix Market coordinate and array files into dense and CSR matrices
+TEST(AutAp2024SpringHW1, io_LoadMatrixMarket) {
+	const char *general = "%%MatrixMarket matrix coordinate real general\n"
+	                      "% comment\n"
+	                      "3 4 4\n"
+	                      "1 1 1.5\n"
+	                      "3 4 -2\n"
+	                      "2 2 3\n"
+	                      "3 1 4\n";
+	Matrix<double> dense{{1.5, 0, 0, 0}, {0, 3, 0, 0}, {4, 0, 0, -2}};
+	EXPECT_EQ(parse_matrix_market(general), dense);
+
+	auto sparse = parse_matrix_market_sparse(general);
+	EXPECT_EQ(sparse.nonzeros(), 4u);
+	EXPECT_EQ(sparse.row_ptr(), (std::vector<std::size_t>{0, 1, 2, 4}));
+	EXPECT_EQ(sparse.col_index(), (std::vector<std::size_t>{0, 1, 0, 3}));
+	EXPECT_EQ(sparse.to_dense(), dense);
+	std::vector<double> x{1, 2, 3, 4};
+	EXPECT_EQ(multiply(sparse, x), gemv(dense, x));
+
+	const char *symmetric = "%%MatrixMarket matrix coordinate integer symmetric\n"
+	                        "3 3 3\n"
+	                        "1 1 2\n"
+	                        "3 1 5\n"
+	                        "3 2 -1\n";
+	Matrix<int> sym{{2, 0, 5}, {0, 0, -1}, {5, -1, 0}};
+	EXPECT_EQ(parse_matrix_market<int>(symmetric), sym);
+	EXPECT_EQ(parse_matrix_market_sparse<int>(symmetric).to_dense(), sym);
+
+	const char *pattern = "%%MatrixMarket matrix coordinate pattern skew-symmetric\n"
+	                      "2 2 1\n"
+	                      "2 1\n";
+	EXPECT_EQ(parse_matrix_market<int>(pattern), (Matrix<int>{{0, -1}, {1, 0}}));
+
+	// array 格式按列存储; 对称时只给出下三角
+	EXPECT_EQ((parse_matrix_market<double, Layout::ColMajor>("%%MatrixMarket matrix array real general\n2 3\n1\n2\n3\n4\n5\n6\n")),
+	          (Matrix<double, Layout::ColMajor>{{1, 3, 5}, {2, 4, 6}}));
+	EXPECT_EQ(parse_matrix_market("%%MatrixMarket matrix array real symmetric\n3 3\n1\n2\n3\n4\n5\n6\n"),
+	          (Matrix<double>{{1, 2, 3}, {2, 4, 5}, {3, 5, 6}}));
+
+	auto c = parse_matrix_market<std::complex<double>>("%%MatrixMarket matrix coordinate complex hermitian\n2 2 2\n1 1 1 0\n2 1 2 3\n");
+	EXPECT_EQ(c(0, 1), std::complex<double>(2, -3));
+	EXPECT_THROW(parse_matrix_market(std::string_view("%%MatrixMarket matrix coordinate complex general\n1 1 1\n1 1 1 0\n")),
+	             std::invalid_argument);
+	EXPECT_THROW(parse_matrix_market("%%MatrixMarket matrix coordinate real general\n2 2 2\n1 1 1\n"), std::invalid_argument);
+	EXPECT_THROW(parse_matrix_market("%%MatrixMarket matrix coordinate real general\n2 2 1\n3 1 1\n"), std::out_of_range);
+
+	// 值之后的多余内容, 以及把 real 文件读入整数矩阵 (会截断小数), 都应报错
+	EXPECT_THROW(parse_matrix_market("%%MatrixMarket matrix coordinate real general\n2 2 1\n2 2 2.75 garbage\n"),
+	             std::invalid_argument);
+	EXPECT_THROW(parse_matrix_market("%%MatrixMarket matrix array real general\n1 2\n1\n2 3\n"), std::invalid_argument);
+	EXPECT_THROW(parse_matrix_market<int>("%%MatrixMarket matrix coordinate real general\n2 2 1\n1 1 1.5\n"),
+	             std::invalid_argument);
+	EXPECT_EQ(parse_matrix_market<int>("%%MatrixMarket matrix coordinate integer general\n1 2 1\n1 2 7  \n"),
+	          (Matrix<int>{{0, 7}}));
+}
+
+// "============================================="
+// "             Unchecked API Tests             "
+// "============================================="
+
+// Test unchecked variants are noexcept and agree with the checked API
+TEST(AutAp2024SpringHW1, unchecked_MatchesChecked) {
+	Matrix<int> a(random_nested(5, 7, 61)), b(random_nested(5, 7, 62)), c(random_nested(7, 3, 63));
+	auto bc = relayout<Layout::ColMajor>(b);
+
+	static_assert(noexcept(unchecked::sum_sub<ElementOp::Sub>(a, b)));
+	static_assert(noexcept(unchecked::multiply(a, c)));
+	static_assert(noexcept(unchecked::trace(a)));
+
+	EXPECT_EQ(unchecked::sum_sub(a, b), sum_sub(a, b));
+	EXPECT_EQ(unchecked::sum_sub<ElementOp::Sub>(a, bc), sum_sub(a, bc, "sub"));
+	EXPECT_EQ(unchecked::hadamard_product(a, bc), hadamard_product(a, b));
+	EXPECT_EQ(unchecked::multiply(a, 3), multiply(a, 3));
+	EXPECT_EQ(unchecked::multiply(a, c), multiply(a, c));
+
+	// 写入子块视图, 输出与输入存储顺序不同
+	Matrix<int, Layout::ColMajor> out(6, 8, -1);
+	unchecked::elementwise<ElementOp::Sum>(a.view(), bc.view(), out.view().block(1, 1, 5, 7));
+	auto ref = sum_sub(a, b);
+	for (std::size_t i = 0; i < 5; ++i)
+		for (std::size_t j = 0; j < 7; ++j)
+			EXPECT_EQ(out(i + 1, j + 1), ref(i, j));
+	EXPECT_EQ(out(0, 0), -1);
+
+	Matrix<int> square(random_nested(6, 6, 64));
+	EXPECT_EQ(unchecked::trace(square), trace(square.to_nested()));
+
+	auto na = random_nested(4, 4, 65), nb = random_nested(4, 4, 66);
+	EXPECT_EQ(unchecked::sum_sub<ElementOp::Sub>(na, nb), sum_sub(na, nb, "sub"));
+	EXPECT_EQ(unchecked::hadamard_product(na, nb), hadamard_product(na, nb));
+	EXPECT_EQ(unchecked::trace(na), trace(na));
+}
+
+// "============================================="
+// "             Batched GEMM Tests              "
+// "============================================="
+
+// Test strided batched GEMM against per-item multiply, including broadcast operands
+TEST(AutAp2024SpringHW1, blas_StridedBatchedGemm) {
+	const std::size_t m = 64, k = 48, n = 40, batch = 37;
+	Matrix<double> a(batch * m, k), c(batch * m, n, 1);
+	Matrix<double, Layout::ColMajor> b(k, batch * n);
+	std::mt19937 gen(71);
+	std::uniform_real_distribution<double> dist(-1, 1);
+	for (std::size_t i = 0; i < a.rows(); ++i)
+		for (std::size_t j = 0; j < k; ++j)
+			a(i, j) = dist(gen);
+	for (std::size_t i = 0; i < k; ++i)
+		for (std::size_t j = 0; j < b.cols(); ++j)
+			b(i, j) = dist(gen);
+
+	// A 的各项纵向堆叠 (行主序), B 的各项横向排列 (列主序), 步长都是矩阵元素数
+	gemm_strided_batched(2.0, a.view().block(0, 0, m, k), m * k, b.view().block(0, 0, k, n), k * n,
+	                     0.5, c.view().block(0, 0, m, n), m * n, batch);
+	for (std::size_t t = 0; t < batch; ++t) {
+		Matrix<double> ref = multiply(a.view().block(t * m, 0, m, k), b.view().block(0, t * n, k, n));
+		for (std::size_t i = 0; i < m; ++i)
+			for (std::size_t j = 0; j < n; ++j)
+				EXPECT_NEAR(c(t * m + i, j), 2 * ref(i, j) + 0.5, 1e-12);
+	}
+
+	// 步长为 0 的 A 被所有项共用; 批量小于线程数时逐项并行
+	Matrix<double> shared = detail::convert<double>(Matrix<int>(random_nested(m, k, 72))), out(3 * m, n);
+	gemm_strided_batched(1.0, shared.view(), 0, b.view().block(0, 0, k, n), k * n, 0.0, out.view().block(0, 0, m, n), m * n, 3);
+	for (std::size_t t = 0; t < 3; ++t) {
+		Matrix<double> ref = multiply(shared.view(), b.view().block(0, t * n, k, n));
+		for (std::size_t i = 0; i < m; ++i)
+			for (std::size_t j = 0; j < n; ++j)
+				EXPECT_NEAR(out(t * m + i, j), ref(i, j), 1e-12);
+	}
+	EXPECT_THROW(gemm_strided_batched(1.0, shared.view(), 0, b.view().block(0, 0, k, n), k * n, 0.0,
+	                                  out.view().block(0, 0, m, n), m, 3),
+	             std::invalid_argument);
+
+	// 指针数组形式, 复数单线程路径不拆分平面
+	std::vector<Matrix<cd>> ca, cb, cc;
+	std::vector<MatrixView<const cd>> va, vb;
+	std::vector<MatrixView<cd>> vc;
+	for (std::size_t t = 0; t < 16; ++t) {
+		ca.push_back(random_complex(40, 50, 80 + t));
+		cb.push_back(random_complex(50, 30, 100 + t));
+		cc.emplace_back(40, 30);
+	}
+	for (std::size_t t = 0; t < 16; ++t) {
+		va.push_back(std::as_const(ca[t]).view());
+		vb.push_back(std::as_const(cb[t]).view());
+		vc.push_back(cc[t].view());
+	}
+	gemm_batched(cd(1), va, vb, cd(0), vc);
+	for (std::size_t t = 0; t < 16; ++t)
+		EXPECT_EQ(cc[t], multiply(ca[t], cb[t]));
+
+	// 输出可以是同一矩阵中互不相交的子块, 但不能重叠
+	Matrix<double> whole(m, 2 * n);
+	std::vector<MatrixView<const double>> pa(2, std::as_const(shared).view());
+	std::vector<MatrixView<const double, Layout::ColMajor>> pb(2, std::as_const(b).view().block(0, 0, k, n));
+	std::vector<MatrixView<double>> pc{whole.view().block(0, n, m, n), whole.view().block(0, 0, m, n)};
+	gemm_batched(1.0, pa, pb, 0.0, pc);
+	Matrix<double> ref = multiply(shared.view(), b.view().block(0, 0, k, n));
+	for (std::size_t i = 0; i < m; ++i)
+		for (std::size_t j = 0; j < n; ++j) {
+			EXPECT_NEAR(whole(i, j), ref(i, j), 1e-12);
+			EXPECT_NEAR(whole(i, n + j), ref(i, j), 1e-12);
+		}
+	pc[0] = whole.view().block(0, 1, m, n);
+	EXPECT_THROW(gemm_batched(1.0, pa, pb, 0.0, pc), std::invalid_argument);
+}
+
+// "============================================="
+// "             Tuning Tests                    "
+// "============================================="
+
+// Test the tuning cache format: sections keyed by CPU model, unknown keys ignored
+TEST(AutAp2024SpringHW1, tuning_ParseAndFormat) {
+	std::string text = "# cache\n[cpu A]\ngemm_block_m = 32\nlu_panel=128\nunknown = 5\n[cpu B]\ngemm_unroll = 3\n";
+	auto a = parse_tuning(text, "cpu A");
+	ASSERT_TRUE(a.has_value());
+	EXPECT_EQ(a->gemm_block_m, 32u);
+	EXPECT_EQ(a->lu_panel, 128u);
+	EXPECT_EQ(a->gemm_block_k, TuningConfig{}.gemm_block_k);
+	EXPECT_EQ(parse_tuning(text, "cpu B")->gemm_unroll, 2u);// 只允许 1, 2, 4
+	EXPECT_FALSE(parse_tuning(text, "cpu C").has_value());
+
+	TuningConfig c;
+	c.transpose_block = 64;
+	std::string updated = format_tuning(text, "cpu A", c);
+	EXPECT_EQ(parse_tuning(updated, "cpu A"), c);
+	EXPECT_EQ(parse_tuning(updated, "cpu B"), parse_tuning(text, "cpu B"));
+	EXPECT_EQ(parse_tuning(format_tuning(updated, "cpu C", c), "cpu C"), c);
+
+	auto path = std::filesystem::temp_directory_path() / "algebra_tuning_test" / "tuning.conf";
+	save_tuning(c, path, "cpu D");
+	save_tuning(*a, path, "cpu E");
+	EXPECT_EQ(load_tuning(path, "cpu D"), c);
+	EXPECT_EQ(load_tuning(path, "cpu E"), a);
+	std::filesystem::remove_all(path.parent_path());
+	EXPECT_FALSE(load_tuning(path, "cpu D").has_value());
+}
+
+// Test results do not depend on the tuning parameters, and autotune applies its result
+TEST(AutAp2024SpringHW1, tuning_ResultsIndependentOfConfig) {
+	TuningConfig saved = tuning();
+	auto random_double = [](std::size_t rows, std::size_t cols, unsigned seed) {
+		return detail::convert<double>(Matrix<int>(random_nested(rows, cols, seed)));
+	};
+	Matrix<double> a = random_double(150, 170, 91), b = random_double(170, 130, 92);
+	Matrix<double> square = random_double(150, 150, 93), rhs = random_double(150, 130, 94);
+	for (std::size_t i = 0; i < 150; ++i)
+		square(i, i) += 2000;
+
+	auto product = multiply(a, b);
+	auto lu = LU<double>(square).solve(rhs);
+	auto moved = relayout<Layout::ColMajor>(a);
+
+	TuningConfig odd;
+	odd.gemm_block_m = 24;
+	odd.gemm_block_k = 40;
+	odd.gemm_block_n = 56;
+	odd.gemm_unroll = 2;
+	odd.small_gemm = 1;
+	odd.parallel_gemm = 1;
+	odd.transpose_block = 7;
+	odd.lu_panel = 13;
+	set_tuning(odd);
+	EXPECT_EQ(tuning(), odd);
+	EXPECT_EQ(multiply(a, b), product);
+	auto lu_odd = LU<double>(square).solve(rhs);
+	for (std::size_t i = 0; i < 150; ++i)
+		for (std::size_t j = 0; j < 130; ++j)
+			EXPECT_NEAR(lu_odd(i, j), lu(i, j), 1e-12);
+	EXPECT_EQ(relayout<Layout::ColMajor>(a), moved);
+
+	TuneOptions opts;
+	opts.size = 64;
+	opts.repeats = 1;
+	auto tuned = autotune(opts);
+	EXPECT_EQ(tuning(), tuned);
+	EXPECT_EQ(multiply(a, b), product);
+	set_tuning(saved);
+}
+
+// "============================================="
+// "             Instrumentation Tests           "
+// "============================================="
+
+// Test the registry aggregates events, buckets shapes and forwards to the sink
+TEST(AutAp2024SpringHW1, instrument_Registry) {
+	instrument::reset();
+	std::vector<std::string> seen;
+	instrument::set_sink([&](const instrument::Event &e) { seen.emplace_back(e.op); });
+	{
+		instrument::Scope outer("outer_op", 100, 3, 1, 10, 20);
+		// 嵌套的调用计入外层
+		instrument::Scope inner("inner_op", 1, 1, 1, 1, 1);
+	}
+	{
+		instrument::Scope again("outer_op", 120, 4, 1, 5, 0);
+	}
+	instrument::set_sink(nullptr);
+
+	auto stats = instrument::snapshot();
+	ASSERT_EQ(stats.count("outer_op"), 1u);
+	EXPECT_EQ(stats.count("inner_op"), 0u);
+	EXPECT_EQ(stats["outer_op"].calls, 2u);
+	EXPECT_EQ(stats["outer_op"].flops, 15);
+	EXPECT_EQ(stats["outer_op"].bytes, 20);
+	EXPECT_GE(stats["outer_op"].seconds, 0);
+	EXPECT_EQ(stats["outer_op"].shapes.size(), 1u);
+	EXPECT_EQ((stats["outer_op"].shapes.begin()->first), (instrument::ShapeBucket{128, 4, 1}));
+	EXPECT_EQ(seen, (std::vector<std::string>{"outer_op", "outer_op"}));
+
+	std::ostringstream out;
+	instrument::report(out);
+	if (instrument::enabled)
+		EXPECT_NE(out.str().find("outer_op"), std::string::npos);
+	else
+		EXPECT_NE(out.str().find("disabled"), std::string::npos);
+	instrument::reset();
+}
+
+// Test public entry points are recorded when instrumentation is compiled in
+TEST(AutAp2024SpringHW1, instrument_Hooks) {
+	instrument::reset();
+	Matrix<double> a(40, 30, 1.0), b(30, 20, 2.0);
+	multiply(a, b);
+	multiply(a, b);
+	determinant(MATRIX<double>{{1, 2, 3}, {0, 1, 4}, {5, 6, 0}});
+	LU<double>(Matrix<double>{{4, 3}, {6, 3}});
+	auto stats = instrument::snapshot();
+	if constexpr (instrument::enabled) {
+		EXPECT_EQ(stats["multiply"].calls, 2u);
+		EXPECT_EQ(stats["multiply"].flops, 2 * 2.0 * 40 * 30 * 20);
+		EXPECT_EQ(stats["multiply"].shapes.begin()->first, (instrument::ShapeBucket{64, 32, 32}));
+		// 递归只记录最外层
+		EXPECT_EQ(stats["determinant"].calls, 1u);
+		EXPECT_EQ(stats["LU"].calls, 1u);
+	} else {
+		EXPECT_TRUE(stats.empty());
+	}
+	instrument::reset();
+}
+
+// "============================================="
+// "              Task Graph Tests               "
+// "============================================="
+
+// Test a multi-step pipeline matches the step-by-step computation on a multi-threaded pool
+TEST(AutAp2024SpringHW1, task_graph_Pipeline) {
+	auto random_double = [](std::size_t rows, std::size_t cols, unsigned seed) {
+		return detail::convert<double>(Matrix<int>(random_nested(rows, cols, seed)));
+	};
+	Matrix<double> a = random_double(96, 80, 101), b = random_double(96, 80, 102);
+	Matrix<double> c = random_double(80, 80, 103), d = random_double(80, 50, 104);
+	for (std::size_t i = 0; i < 80; ++i)
+		c(i, i) += 5000;
+
+	Matrix<double> product = multiply(transpose(a), b);
+	Matrix<double> expected = multiply(LU<double>(sum_sub(product, c)).inverse(), d);
+
+	ThreadPool pool{4};
+	TaskGraph<double> graph(16, pool);
+	auto at = graph.transpose(graph.input(a));
+	auto p = graph.multiply(at, graph.input(b));
+	auto s = graph.sum_sub(p, graph.input(c));
+	auto r = graph.multiply(graph.inverse(s), graph.input(d));
+	auto h = graph.hadamard_product(graph.multiply(s, 0.5), s);
+	graph.keep(p);
+	graph.run();
+
+	EXPECT_EQ(graph.rows(r), 80u);
+	EXPECT_EQ(graph.cols(r), 50u);
+	EXPECT_EQ(graph.result(p), product);
+	for (std::size_t i = 0; i < 80; ++i) {
+		for (std::size_t j = 0; j < 50; ++j)
+			EXPECT_NEAR(graph.result(r)(i, j), expected(i, j), 1e-9);
+		EXPECT_DOUBLE_EQ(graph.result(h)(i, i), 0.5 * (product(i, i) + c(i, i)) * (product(i, i) + c(i, i)));
+	}
+	// 未保留的中间结果已被回收
+	EXPECT_THROW(graph.result(at), std::invalid_argument);
+
+	// 再次运行得到同样的结果
+	graph.run();
+	EXPECT_EQ(graph.result(p), product);
+}
+
+// Test intermediate buffers are reused once their consumers finish
+TEST(AutAp2024SpringHW1, task_graph_RecyclesBuffers) {
+	Matrix<int> a(random_nested(40, 40, 105));
+	TaskGraph<int> graph(8);
+	auto node = graph.input(a);
+	for (int i = 0; i < 6; ++i)
+		node = graph.transpose(node);
+	graph.run();
+	EXPECT_EQ(graph.result(node), a);
+	// 每个转置都需要完整的输入, 相邻两个节点交替使用两个缓冲区
+	EXPECT_EQ(graph.allocations(), 2u);
+}
+
+// Test shape errors are reported when building the graph and failures when running it
+TEST(AutAp2024SpringHW1, task_graph_Errors) {
+	Matrix<double> a(3, 4, 1.0), singular(3, 3, 1.0);
+	TaskGraph<double> graph;
+	auto x = graph.input(a);
+	EXPECT_THROW(graph.multiply(x, x), std::invalid_argument);
+	EXPECT_THROW(graph.sum_sub(x, graph.transpose(x)), std::invalid_argument);
+	EXPECT_THROW(graph.inverse(x), std::invalid_argument);
+	EXPECT_THROW(graph.input(Matrix<double>{}), std::invalid_argument);
+
+	auto inv = graph.inverse(graph.input(singular));
+	graph.multiply(inv, x);
+	EXPECT_THROW(graph.run(), std::invalid_argument);
+}
+
+// "============================================="
+// "                 Async Tests                 "
+// "============================================="
+
+// Await a single operation from a coroutine
+template<typename R>
+static async::Task<R> await_operation(async::Operation<R> operation) {
+	co_return co_await operation;
+}
+
+// Solve a * x = b with two awaited operations
+static async::Task<Matrix<double>> async_solve(Matrix<double> a, Matrix<double> b, async::Options options) {
+	Matrix<double> inv = co_await async::inverse(a, std::move(options));
+	co_return co_await async::multiply(inv, b);
+}
+
+// Test async operations match the synchronous versions and report progress up to completion
+TEST(AutAp2024SpringHW1, async_MultiplyAndInverse) {
+	Matrix<double> a = detail::convert<double>(Matrix<int>(random_nested(150, 150, 111)));
+	Matrix<double> b = detail::convert<double>(Matrix<int>(random_nested(150, 40, 112)));
+	for (std::size_t i = 0; i < 150; ++i)
+		a(i, i) += 3000;
+
+	std::vector<double> progress;
+	async::Options options;
+	options.progress = [&](double fraction) { progress.push_back(fraction); };
+	Matrix<double> x = async::sync_wait(async_solve(a, b, options));
+	Matrix<double> expected = LU<double>(a).solve(b);
+	for (std::size_t i = 0; i < 150; ++i)
+		for (std::size_t j = 0; j < 40; ++j)
+			EXPECT_NEAR(x(i, j), expected(i, j), 1e-12);
+
+	ASSERT_GE(progress.size(), 3u);
+	EXPECT_EQ(progress.front(), 0);
+	EXPECT_EQ(progress.back(), 1);
+	EXPECT_TRUE(std::is_sorted(progress.begin(), progress.end()));
+
+	MATRIX<int> na = random_nested(30, 20, 113), nb = random_nested(20, 25, 114);
+	EXPECT_EQ(async::sync_wait(await_operation(async::multiply(na, nb))), multiply(na, nb));
+
+	MATRIX<double> small{{4, 7, 2}, {3, 6, 1}, {2, 5, 3}};
+	MATRIX<double> inv = async::sync_wait(await_operation(async::inverse(small))), ref = inverse(small);
+	for (std::size_t i = 0; i < 3; ++i)
+		for (std::size_t j = 0; j < 3; ++j)
+			EXPECT_NEAR(inv[i][j], ref[i][j], 1e-12);
+
+	EXPECT_EQ(async::sync_wait(await_operation(async::run([&] { return trace(small); }))), trace(small));
+}
+
+// Test cancellation before and during an operation, and error propagation
+TEST(AutAp2024SpringHW1, async_Cancellation) {
+	Matrix<double> a(256, 64, 1.0), b(64, 64, 2.0);
+
+	async::CancellationSource before;
+	before.cancel();
+	async::Options options;
+	options.cancel = before.token();
+	EXPECT_THROW(async::sync_wait(await_operation(async::multiply(a, b, options))), async::Cancelled);
+
+	// 在进度回调中取消, 运算在下一个块边界停止
+	async::CancellationSource during;
+	double last = 0;
+	options.cancel = during.token();
+	options.progress = [&](double fraction) {
+		last = fraction;
+		if (fraction > 0)
+			during.cancel();
+	};
+	EXPECT_THROW(async::sync_wait(await_operation(async::multiply(a, b, options))), async::Cancelled);
+	EXPECT_GT(last, 0);
+	EXPECT_LT(last, 1);
+
+	EXPECT_THROW(static_cast<void>(async::multiply(a, a)), std::invalid_argument);
+	EXPECT_THROW(static_cast<void>(async::inverse(a)), std::invalid_argument);
+	EXPECT_THROW(async::sync_wait(await_operation(async::inverse(Matrix<double>(3, 3, 1.0)))), std::invalid_argument);
+}
+
+// Test the resume hook hands the awaiting coroutine back to the caller's executor
+TEST(AutAp2024SpringHW1, async_ResumeHook) {
+	std::atomic<int> resumed{0};
+	async::Options options;
+	options.resume = [&](std::coroutine_handle<> handle) {
+		++resumed;
+		handle.resume();
+	};
+	Matrix<double> a(64, 64, 1.0);
+	Matrix<double> product = async::sync_wait(await_operation(async::multiply(a, a, options)));
+	EXPECT_EQ(product(3, 5), 64);
+	// 没有工作线程时运算在等待者的线程中直接完成, 不需要恢复
+	EXPECT_EQ(resumed.load(), ThreadPool::instance().concurrency() > 1 ? 1 : 0);
+}
+
+// "============================================="
+// "           Multi-process Tests               "
+// "============================================="
+
+// Test sharded multiply in forked workers writes the shared result in place
+TEST(AutAp2024SpringHW1, shm_Multiply) {
+	Matrix<double> a = detail::convert<double>(Matrix<int>(random_nested(150, 90, 121)));
+	Matrix<double> b = detail::convert<double>(Matrix<int>(random_nested(90, 110, 122)));
+	SharedMatrix<double> sa(a), sb(b);
+	Matrix<double> expected = multiply(a, b);
+
+	for (std::size_t processes: {1, 3, 5}) {
+		SharedMatrix<double> c = multiply(sa, sb, {processes, 32});
+		EXPECT_EQ(c.rows(), 150u);
+		EXPECT_EQ(c.cols(), 110u);
+		EXPECT_EQ(c.to_matrix(), expected);
+	}
+
+	// 列主序输入在复制进共享内存时转换
+	SharedMatrix<double> col(relayout<Layout::ColMajor>(b));
+	EXPECT_EQ(multiply(sa, col, {2, 64}).to_matrix(), expected);
+
+	EXPECT_THROW(multiply(sa, sa), std::invalid_argument);
+	EXPECT_THROW(multiply(SharedMatrix<double>{}, sb), std::invalid_argument);
+}
+
+// Test elementwise operations split rows across worker processes
+TEST(AutAp2024SpringHW1, shm_Elementwise) {
+	Matrix<int> a(random_nested(70, 40, 123)), b(random_nested(70, 40, 124));
+	SharedMatrix<int> sa(a), sb(b);
+	ProcessOptions options{4, 256, false};
+	EXPECT_EQ(sum_sub(sa, sb, "sum", options).to_matrix(), sum_sub(a, b));
+	EXPECT_EQ(sum_sub(sa, sb, "sub", options).to_matrix(), sum_sub(a, b, "sub"));
+	EXPECT_EQ(hadamard_product(sa, sb, options).to_matrix(), hadamard_product(a, b));
+
+	SharedMatrix<int> zero(3, 2);
+	EXPECT_EQ(zero(2, 1), 0);
+	EXPECT_THROW(sum_sub(sa, zero), std::invalid_argument);
+}